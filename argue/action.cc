@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <sstream>
 
 #include "argue/exception.h"
 #include "argue/parse.h"
@@ -58,6 +59,10 @@ bool ActionBase::validate() {
   return true;
 }
 
+void ActionBase::apply_defaults(const ParseContext& ctx) {}
+
+void ActionBase::apply_unused_defaults(const ParseContext& ctx) {}
+
 bool ActionBase::is_required() const {
   if (usage_ == USAGE_POSITIONAL) {
     if (!has_nargs_) {
@@ -83,6 +88,10 @@ int ActionBase::get_nargs(int default_value) const {
   }
 }
 
+int ActionBase::get_value_count() const {
+  return INVALID_NARGS;
+}
+
 std::string ActionBase::get_metavar(const std::string& default_value) const {
   if (has_metavar_) {
     return metavar_;
@@ -99,6 +108,21 @@ std::string ActionBase::get_help(size_t column_width) const {
   }
 }
 
+ParseResult fail_parse(const ParseContext& ctx, size_t token_index,
+                       const std::string& message, Exception::TypeNo type) {
+  if (ctx.error) {
+    ctx.error->type = type;
+    ctx.error->token_index = token_index;
+    ctx.error->message = message;
+    ctx.error->usage = ctx.parser ? ctx.parser->get_usage_string() : "";
+  }
+  return PARSE_EXCEPTION;
+}
+
+TypeId ActionBase::get_target_type() const {
+  return target_type_;
+}
+
 void ActionBase::set_parser(Parser* parser) {
   ARGUE_ASSERT(CONFIG_ERROR, !parser_)
       << "Invalid re-use of action object for " << type_name_;
@@ -107,19 +131,10 @@ void ActionBase::set_parser(Parser* parser) {
 
 Subparsers::Subparsers(const Metadata& metadata) : metadata_(metadata) {}
 
-bool Subparsers::validate() {
-  bool ok = StoreValue<std::string>::validate();
-  for (auto& pair : subparser_map_) {
-    pair.second->validate();
-  }
-  return ok;
-}
-
 std::string Subparsers::get_help(size_t column_width) const {
   std::list<std::string> parts;
-  if (!this->subparser_map_.empty()) {
-    parts.push_back(
-        fmt::format("[{}]", string::join(keys(this->subparser_map_), ", ")));
+  if (!this->entries_.empty()) {
+    parts.push_back(fmt::format("[{}]", join_names(", ")));
   }
   if (this->has_help_) {
     parts.push_back(this->help_);
@@ -127,73 +142,265 @@ std::string Subparsers::get_help(size_t column_width) const {
   return string::join(parts, "\n");
 }
 
-void Subparsers::consume_args(const ParseContext& ctx,
-                              std::list<std::string>* args,
+void Subparsers::consume_args(const ParseContext& ctx, TokenStream* args,
                               ActionResult* result) {
   ARGUE_ASSERT(CONFIG_ERROR, this->nargs_ == EXACTLY_ONE)
       << fmt::format("Invalid nargs_={}", this->nargs_);
-  ArgType arg_type = get_arg_type(args->front());
+  ArgType arg_type = args->front_type();
+
+  if (arg_type != POSITIONAL) {
+    result->code = fail_parse(
+        ctx, args->index(),
+        fmt::format("Expected a command name but instead got a flag {}",
+                    args->front().to_string()));
+    return;
+  }
+
+  StringPiece command = args->front();
+  size_t num_matches = 0;
+  const Entry* entry = match_command(command, &num_matches);
+  if (num_matches > 1) {
+    result->code = fail_parse(
+        ctx, args->index(),
+        fmt::format("Command '{}' is not unique as an implicit prefix of "
+                    "known commands",
+                    command.to_string()));
+    return;
+  }
+  if (!entry) {
+    result->code = fail_parse(
+        ctx, args->index(),
+        fmt::format("Invalid value '{}' choose from '{}'", command.to_string(),
+                    join_names("', '")));
+    return;
+  }
+  args->pop_front();
+
+  if (this->destination_) {
+    this->destination_->assign(ctx.target.get(), entry->get_name());
+  }
+  // NOTE(josh): by reference, so that concurrent parses do not contend on the
+  // reference count of the subparser.
+  const std::shared_ptr<Parser>& subparser = entry->get_parser();
+  result->code =
+      static_cast<ParseResult>(subparser->parse_args_impl(args, ctx));
+}
+
+Subparsers::EntryList::const_iterator Subparsers::begin() const {
+  return entries_.begin();
+}
+
+Subparsers::EntryList::const_iterator Subparsers::end() const {
+  return entries_.end();
+}
+
+// Marks an unoccupied slot in the hash table
+static const size_t kEmptySlot = ~static_cast<size_t>(0);
+
+const Subparsers::Entry* Subparsers::find_command(
+    const StringPiece& command) const {
+  if (hash_table_.empty()) {
+    return nullptr;
+  }
+  size_t mask = hash_table_.size() - 1;
+  for (size_t idx = hash_string(command) & mask;
+       hash_table_[idx].entry_idx != kEmptySlot; idx = (idx + 1) & mask) {
+    if (hash_table_[idx].name == command) {
+      return entries_[hash_table_[idx].entry_idx].get();
+    }
+  }
+  return nullptr;
+}
+
+const Subparsers::Entry* Subparsers::match_command(const StringPiece& command,
+                                                   size_t* num_matches) const {
+  const Entry* entry = find_command(command);
+  if (entry || command.empty()) {
+    *num_matches = entry ? 1 : 0;
+    return entry;
+  }
 
-  if (arg_type == POSITIONAL) {
-    std::string local_command;
+  // NOTE(josh): a command and its aliases may share a prefix, so we count
+  // the distinct commands matched rather than the number of names.
+  auto range = prefix_range(
+      sorted_names_.begin(), sorted_names_.end(), command,
+      [](const NameEntry& entry) -> const StringPiece& { return entry.name; });
+  std::vector<size_t> matches;
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    if (std::find(matches.begin(), matches.end(), iter->entry_idx) ==
+        matches.end()) {
+      matches.push_back(iter->entry_idx);
+    }
+  }
+  *num_matches = matches.size();
+  if (matches.size() != 1) {
+    return nullptr;
+  }
+  return entries_[matches[0]].get();
+}
 
-    int parse_result = parse(args->front(), &local_command);
-    ARGUE_ASSERT(INPUT_ERROR, parse_result == 0)
-        << fmt::format("Unable to parse command '{}'", args->front());
-    args->pop_front();
+void Subparsers::add_entry(std::unique_ptr<Entry> entry) {
+  // Check all of the names before modifying anything so that a configuration
+  // error leaves the existing index intact.
+  ARGUE_ASSERT(CONFIG_ERROR, find_command(entry->get_name()) == nullptr)
+      << "Duplicate subcommand name " << entry->get_name();
+  const std::vector<std::string>& aliases = entry->get_aliases();
+  for (size_t idx = 0; idx < aliases.size(); ++idx) {
+    const std::string& alias = aliases[idx];
+    ARGUE_ASSERT(CONFIG_ERROR, find_command(alias) == nullptr)
+        << "Duplicate subcommand name " << alias;
+    ARGUE_ASSERT(CONFIG_ERROR, alias != entry->get_name())
+        << "Subcommand " << alias << " is an alias of itself";
+    ARGUE_ASSERT(CONFIG_ERROR, std::find(aliases.begin(), aliases.begin() + idx,
+                                         alias) == aliases.begin() + idx)
+        << "Duplicate alias " << alias << " for subcommand "
+        << entry->get_name();
+  }
 
-    auto iter = subparser_map_.find(local_command);
-    ARGUE_ASSERT(INPUT_ERROR, iter != subparser_map_.end())
-        << "Invalid value '" << local_command << "' choose from '"
-        << string::join(keys(subparser_map_), "', '") << "'";
+  size_t entry_idx = entries_.size();
+  entries_.emplace_back(std::move(entry));
+  const Entry& added = *entries_.back();
+  index_name(added.get_name(), entry_idx, false);
+  for (const std::string& alias : added.get_aliases()) {
+    index_name(alias, entry_idx, true);
+  }
+}
 
-    if (this->destination_) {
-      this->destination_->assign(local_command);
+void Subparsers::index_name(const StringPiece& name, size_t entry_idx,
+                            bool is_alias) {
+  ARGUE_ASSERT(CONFIG_ERROR, find_command(name) == nullptr)
+      << "Duplicate subcommand name " << name;
+  NameEntry new_entry{name, entry_idx, is_alias};
+
+  auto iter = std::lower_bound(
+      sorted_names_.begin(), sorted_names_.end(), name,
+      [](const NameEntry& lhs, const StringPiece& rhs) {
+        return lhs.name < rhs;
+      });
+  sorted_names_.insert(iter, new_entry);
+
+  // Keep the load factor at or below one half so that probe sequences stay
+  // short. When the table grows we simply rebuild it from the sorted index.
+  std::vector<const NameEntry*> to_insert;
+  if (2 * sorted_names_.size() > hash_table_.size()) {
+    size_t table_size = hash_table_.empty() ? 16 : 2 * hash_table_.size();
+    hash_table_.assign(table_size, NameEntry{StringPiece(), kEmptySlot, false});
+    for (const NameEntry& entry : sorted_names_) {
+      to_insert.push_back(&entry);
     }
-    std::shared_ptr<Parser> subparser = iter->second;
-    result->code =
-        static_cast<ParseResult>(subparser->parse_args_impl(args, ctx));
   } else {
-    ARGUE_ASSERT(INPUT_ERROR, false) << fmt::format(
-        "Expected a command name but instead got a flag {}", ctx.arg.c_str());
+    to_insert.push_back(&new_entry);
+  }
+
+  size_t mask = hash_table_.size() - 1;
+  for (const NameEntry* entry : to_insert) {
+    size_t idx = hash_string(entry->name) & mask;
+    while (hash_table_[idx].entry_idx != kEmptySlot) {
+      idx = (idx + 1) & mask;
+    }
+    hash_table_[idx] = *entry;
+  }
+}
+
+std::string Subparsers::join_names(const char* separator) const {
+  std::stringstream strm;
+  for (size_t idx = 0; idx < entries_.size(); ++idx) {
+    if (idx > 0) {
+      strm << separator;
+    }
+    strm << entries_[idx]->get_name();
   }
+  return strm.str();
 }
 
-Subparsers::MapType::const_iterator Subparsers::begin() const {
-  return subparser_map_.begin();
+static std::shared_ptr<Parser> make_subparser(
+    const std::string& command, const std::string& prolog,
+    const Subparsers::Metadata& submeta) {
+  Parser::Metadata meta{};
+  meta.add_help = true;
+  meta.add_version = false;
+  meta.name = command;
+  meta.prolog = prolog;
+  meta.command_prefix = submeta.command_prefix;
+  meta.subdepth = submeta.subdepth;
+  return std::shared_ptr<Parser>{new Parser{meta}};
 }
 
-Subparsers::MapType::const_iterator Subparsers::end() const {
-  return subparser_map_.end();
+Subparsers::Entry::Entry(const std::string& name, const SubparserOptions& opts,
+                         const Metadata& meta, const ParserBuilder& builder)
+    : name_(name),
+      aliases_(opts.aliases),
+      prolog_(opts.help),
+      meta_(meta),
+      builder_(builder),
+      built_(false) {}
+
+Subparsers::Entry::Entry(const std::string& name, const SubparserOptions& opts,
+                         const std::shared_ptr<Parser>& parser)
+    : name_(name),
+      aliases_(opts.aliases),
+      prolog_(opts.help),
+      built_(true),
+      parser_(parser) {}
+
+const std::string& Subparsers::Entry::get_name() const {
+  return name_;
+}
+
+const std::vector<std::string>& Subparsers::Entry::get_aliases() const {
+  return aliases_;
+}
+
+std::string Subparsers::Entry::get_prolog(size_t column_width) const {
+  return wrap(prolog_, column_width);
+}
+
+bool Subparsers::Entry::is_built() const {
+  return built_;
+}
+
+const std::shared_ptr<Parser>& Subparsers::Entry::get_parser() const {
+  std::call_once(build_once_, [this]() {
+    if (!parser_) {
+      std::shared_ptr<Parser> parser = make_subparser(name_, prolog_, meta_);
+      builder_(parser.get());
+      parser->freeze();
+      parser_ = parser;
+    }
+    built_ = true;
+  });
+  return parser_;
 }
 
 std::shared_ptr<Parser> Subparsers::add_parser(const std::string& command,
                                                const SubparserOptions& opts) {
-  auto iter = subparser_map_.find(command);
-  if (iter == subparser_map_.end()) {
-    Parser::Metadata meta{};
-    meta.add_help = true;
-    meta.add_version = false;
-    meta.name = command;
-    meta.prolog = opts.help;
-    meta.command_prefix = metadata_.command_prefix;
-    meta.subdepth = metadata_.subdepth;
-    std::shared_ptr<Parser> parser{new Parser{meta}};
-    std::tie(iter, std::ignore) =
-        subparser_map_.emplace(std::make_pair(command, parser));
+  const Entry* existing = find_command(command);
+  if (existing && existing->get_name() == command) {
+    return existing->get_parser();
   }
 
-  return iter->second;
+  std::shared_ptr<Parser> parser =
+      make_subparser(command, opts.help, metadata_);
+  add_entry(std::unique_ptr<Entry>{new Entry{command, opts, parser}});
+  return parser;
+}
+
+void Subparsers::add_lazy_parser(const std::string& command,
+                                 const SubparserOptions& opts,
+                                 const ParserBuilder& builder) {
+  add_entry(
+      std::unique_ptr<Entry>{new Entry{command, opts, metadata_, builder}});
 }
 
 void Subparsers::write_completions(const ParseContext& ctx) {
-  for (auto pair : subparser_map_) {
-    if (string::starts_with(pair.first, ctx.arg)) {
-      (*ctx.auto_complete.debug) << pair.first << "\n";
-      std::cout << pair.first << ctx.auto_complete.ifs;
-    } else {
-      (*ctx.auto_complete.debug) << pair.first << " doesn't match \n";
-    }
+  // NOTE(josh): the name index is sorted, so the names matching the prefix
+  // are contiguous and we can write them out without copying.
+  auto range = prefix_range(
+      sorted_names_.begin(), sorted_names_.end(), ctx.arg,
+      [](const NameEntry& entry) -> const StringPiece& { return entry.name; });
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    (*ctx.auto_complete.debug) << iter->name << "\n";
+    std::cout << iter->name << ctx.auto_complete.ifs;
   }
 }
 
@@ -205,12 +412,14 @@ bool Help::validate() {
   return true;
 }
 
-void Help::consume_args(const ParseContext& ctx, std::list<std::string>* args,
+void Help::consume_args(const ParseContext& ctx, TokenStream* args,
                         ActionResult* result) {
   Parser::HelpOptions opts{kDefaultColumns, 0};
   char* envstr = getenv("ARGUE_HELP_FORMAT");
   if (envstr && std::string(envstr) == "json") {
     opts.format = Parser::HelpOptions::FORMAT_JSON;
+  } else if (envstr && std::string(envstr) == "export") {
+    opts.format = Parser::HelpOptions::FORMAT_EXPORT;
   }
 
   envstr = getenv("ARGUE_HELP_RECURSE");
@@ -218,17 +427,7 @@ void Help::consume_args(const ParseContext& ctx, std::list<std::string>* args,
     opts.recurse = 1;
   }
 
-  // TODO(josh): dumping the outer list brackets here is kindof hacky... seems
-  // like we would really like to pass the json::stream::Dumper instance down
-  // the stack. Then we can open the list here using the dump API.
-  if (opts.format == Parser::HelpOptions::FORMAT_JSON) {
-    (*ctx.out) << "[\n";
-  }
-
   ctx.parser->print_help(ctx.out, opts);
-  if (opts.format == Parser::HelpOptions::FORMAT_JSON) {
-    (*ctx.out) << "]\n";
-  }
   result->code = PARSE_ABORTED;
 }
 
@@ -240,8 +439,8 @@ bool Version::validate() {
   return true;
 }
 
-void Version::consume_args(const ParseContext& ctx,
-                           std::list<std::string>* args, ActionResult* result) {
+void Version::consume_args(const ParseContext& ctx, TokenStream* args,
+                           ActionResult* result) {
   ctx.parser->print_version(ctx.out);
   result->code = PARSE_ABORTED;
 }
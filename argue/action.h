@@ -1,17 +1,24 @@
 #pragma once
 // Copyright 2018-2020 Josh Bialkowski <josh.bialkowski@gmail.com>
 
+#include <atomic>
+#include <functional>
 #include <initializer_list>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <fmt/format.h>
 
+#include "argue/choice_set.h"
+#include "argue/exception.h"
 #include "argue/storage_model.h"
+#include "argue/token_stream.h"
 
 namespace argue {
 
@@ -21,22 +28,69 @@ namespace argue {
 
 class Parser;
 
+// Description of a failed parse, as returned by `Parser::try_parse_args`
+struct ParseError {
+  Exception::TypeNo type;  //< what kind of error it is
+  size_t token_index;      //< index of the offending argument, not counting
+                           //  the program name. If an argument is missing,
+                           //  this is the index where it was expected.
+  std::string message;     //< description of the error
+  std::string usage;       //< usage string of the (sub)parser which rejected
+                           //  the argument
+};
+
+// The object into which member destinations are stored during a parse
+/* Constructed implicitly from a pointer to the options struct, e.g.
+ * `parser.parse_args(&options, argc, argv)`. A default constructed target is
+ * empty, which is fine for parsers whose destinations are all fixed
+ * pointers. */
+class ParseTarget {
+ public:
+  ParseTarget() : object_(nullptr) {}
+
+  template <class Class, typename = typename std::enable_if<
+                             std::is_class<Class>::value>::type>
+  ParseTarget(Class* object)  // NOLINT(runtime/explicit)
+      : object_(object), type_(type_id<Class>()) {}
+
+  // Return a pointer to the target object
+  void* get() const {
+    return object_;
+  }
+
+  // Return the `type_id` of the target object, which is empty if the target
+  // is empty
+  TypeId type() const {
+    return type_;
+  }
+
+ private:
+  void* object_;
+  TypeId type_;
+};
+
 struct AutoCompleteContext {
   bool active{false};  //< True if we are in autocomplete mode
-  std::list<std::string>::iterator
-      comp_word;    //< pointer to the word in the list that needs completion
-  std::string ifs;  //< bash array separator
+  size_t comp_word;    //< index of the token in the stream that needs
+                       //  completion
+  std::string ifs;     //< bash array separator
   std::ostream* debug;  //< debug log
+  bool write_spec{false};  //< True if the completion spec should be written
+                           //  instead of parsing, see
+                           //  `Parser::write_completion_spec`
 };
 
 // Context provided to Action objects during argument parsing
 struct ParseContext {
-  Parser* parser;     //< Pointer to the parser that owns the argument
-  std::ostream* out;  //< output stream where to write any messages
-  std::string arg;    //< the argument that initiated this action, in the case
-                      //  of actions associated with flags. Empty for
-                      //  actions associated with positionals
+  const Parser* parser;  //< Pointer to the parser that owns the argument
+  std::ostream* out;     //< output stream where to write any messages
+  StringPiece arg;       //< the argument that initiated this action, in the
+                         //  case of actions associated with flags. Empty for
+                         //  actions associated with positionals
   AutoCompleteContext auto_complete;
+  ParseError* error;  //< filled with a description of the error if the parse
+                      //  fails, see `fail_parse`
+  ParseTarget target;  //< object into which member destinations are stored
 };
 
 // Enumerates the possible result cases from a call to `parse_args`.
@@ -57,6 +111,15 @@ struct ActionResult {
   ParseResult code;  //< success/failure of the parse
 };
 
+// Record a parse error in the context and return PARSE_EXCEPTION
+/* Actions and parsers call this, rather than throwing, when the command line
+ * is invalid. The action should then store the return value in
+ * `ActionResult::code` and return without consuming further arguments. The
+ * message is only formatted on this path, so it may be expensive. */
+ParseResult fail_parse(const ParseContext& ctx, size_t token_index,
+                       const std::string& message,
+                       Exception::TypeNo type = Exception::INPUT_ERROR);
+
 // Indicates what kind of argument a particular action is associated with
 enum Usage {
   USAGE_POSITIONAL = 0,  //< action is associated with a positional
@@ -91,12 +154,23 @@ class ActionBase {
    * of the action as they'll be caugh regardless of what command line arguments
    * are pumped through the parser.
    *
-   * `Valdate()` has the side effect of assigning default values wherever
-   * they have been configured.
-   *
-   * TODO(josh): move default assignment to a separate function! */
+   * Validation is done once, when the parser is frozen, and must not have any
+   * side effects on the destination. */
   virtual bool validate();
 
+  // Assign default values to the destination, wherever they have been
+  // configured.
+  /* This is called at the start of every parse through the parser which owns
+   * the action, so it is not called for actions of subparsers that the command
+   * line does not select. */
+  virtual void apply_defaults(const ParseContext& ctx);
+
+  // Assign default values to a streaming destination (see `argue::each()`).
+  /* Values passed to a callback can't be taken back, so `apply_defaults`
+   * skips these destinations. Instead this is called at the end of a
+   * successful parse, for the actions which consumed no value. */
+  virtual void apply_unused_defaults(const ParseContext& ctx);
+
   // Return true if the argument is required.
   /* This is used after all arguments are consumed to determine if the command
    * line was valid. If any arguments remain in the queue that are marked
@@ -113,6 +187,14 @@ class ActionBase {
   // constructor!
   virtual int get_nargs(int default_value) const;
 
+  // Return the number of values consumed each time the action is activated.
+  /* This is either a count (zero for flags like `store_true`) or one of
+   * `ONE_OR_MORE`, `ZERO_OR_MORE`. Any other sentinel means that what is
+   * consumed can only be known by executing the action. Shell completion uses
+   * this to answer from a cached spec rather than executing the program, see
+   * `Parser::write_completion_spec`. */
+  virtual int get_value_count() const;
+
   // Return the string used to represent the value of this argument in help
   // text.
   // TODO(josh): remove ``default_value``, just set the default in the
@@ -125,11 +207,12 @@ class ActionBase {
    * content like `choices` or `default` */
   virtual std::string get_help(size_t column_width = 0) const;
 
-  // Parse zero or more argument values out of the list `args`
-  /* Actions should modify args and leave it in a state consistent with
-   * "remaining arguments". */
-  virtual void consume_args(const ParseContext& ctx,
-                            std::list<std::string>* args,
+  // Parse zero or more argument values out of the stream `args`
+  /* Actions should advance args and leave it in a state consistent with
+   * "remaining arguments". Invalid input must be reported through
+   * `fail_parse` and `result->code` rather than by throwing, so that parsing
+   * works when exceptions are disabled. */
+  virtual void consume_args(const ParseContext& ctx, TokenStream* args,
                             ActionResult* result) = 0;
 
   // Assuming that this action were next in the parse queue (e.g. consume_args
@@ -142,6 +225,10 @@ class ActionBase {
   // already been assigned to a parser, then throw an exception.
   void set_parser(Parser* parser);
 
+  // Return the `type_id` of the class whose members this action stores into,
+  // which is empty if the destination (if any) is not a member destination.
+  TypeId get_target_type() const;
+
  protected:
   std::string type_name_;
 
@@ -164,6 +251,7 @@ class ActionBase {
                            //  when constructing usage or help text
 
   Parser* parser_;  //< The parser that this action has been assigned to
+  TypeId target_type_;  //< see `get_target_type()`
 };
 
 // Interface shared by all action objects that support the standard setters.
@@ -178,11 +266,14 @@ class Action : public ActionBase {
   virtual void set_const(const T& value);
 
   void set_default(const T& value);
-  void set_default(const std::vector<T>&& value);
+  void set_default(std::vector<T>&& value);
 
-  void set_choices(const std::vector<T>&& value);
+  // Restrict the values this action accepts. A vector passed as an rvalue is
+  // moved into the set, and a set may be shared with other actions.
+  void set_choices(std::vector<T>&& value);
   void set_choices(const std::vector<T>& value);
   void set_choices(const std::initializer_list<T>& value);
+  void set_choices(const std::shared_ptr<const ChoiceSet<T>>& value);
 
   void set_destination(const std::shared_ptr<StorageModel<T>>& destination);
   void set_destination(T* destination);
@@ -193,9 +284,21 @@ class Action : public ActionBase {
   template <class Allocator>
   void set_destination(std::vector<T, Allocator>* destination);
 
+  // Store into a member of the target supplied to each parse call. The member
+  // may be a scalar, a list, or a vector.
+  template <class Class, class Field>
+  void set_destination(Field Class::*destination);
+
+  template <class Class, class Field>
+  void set_destination(const MemberPath<Class, Field>& destination);
+
  protected:
-  // A list of the valid values allowed to be consumed by this action
-  std::vector<T> choices_;
+  // Return true if `value` is allowed by the choices (if any)
+  bool is_valid_choice(const T& value) const;
+
+  // The valid values allowed to be consumed by this action, or nullptr if
+  // any value is allowed
+  std::shared_ptr<const ChoiceSet<T>> choices_;
 
   // default list of values used to initialize the destination at the start of
   // parsing, if configured
@@ -225,15 +328,30 @@ class StoreValue : public Action<T> {
   virtual ~StoreValue() {}
 
   bool is_scalar() const;
+  int get_value_count() const override;
   std::string get_help(size_t column_width) const override;
   bool validate() override;
-  void consume_args(const ParseContext& ctx, std::list<std::string>* args,
+  void apply_defaults(const ParseContext& ctx) override;
+  void apply_unused_defaults(const ParseContext& ctx) override;
+  void consume_args(const ParseContext& ctx, TokenStream* args,
                     ActionResult* result) override;
 
+  // Write the choices which start with the word being completed. If there are
+  // no choices and `T` is an enum with an `EnumTraits` table, write the names
+  // from the table.
+  void write_completions(const ParseContext& ctx) override;
+
  protected:
-  void consume_scalar(const ParseContext& ctx, std::list<std::string>* args,
+  // If the next token is the word being completed then write its completions
+  // and exit, the same as `Parser::autocomplete`.
+  void complete_value(const ParseContext& ctx, TokenStream* args);
+
+  // Write the default values to the destination
+  void write_defaults(const ParseContext& ctx);
+
+  void consume_scalar(const ParseContext& ctx, TokenStream* args,
                       ActionResult* result);
-  void consume_list(const ParseContext& ctx, std::list<std::string>* args,
+  void consume_list(const ParseContext& ctx, TokenStream* args,
                     ActionResult* result);
 };
 
@@ -247,8 +365,9 @@ class StoreConst : public StoreValue<T> {
   virtual ~StoreConst() {}
   void set_const(const T& value) override;
 
+  int get_value_count() const override;
   bool validate() override;
-  void consume_args(const ParseContext& ctx, std::list<std::string>* args,
+  void consume_args(const ParseContext& ctx, TokenStream* args,
                     ActionResult* result) override;
 
  protected:
@@ -264,7 +383,7 @@ class Help : public Action<void> {
   virtual ~Help() {}
   std::string get_help(size_t column_width) const override;
   bool validate() override;
-  void consume_args(const ParseContext& ctx, std::list<std::string>* args,
+  void consume_args(const ParseContext& ctx, TokenStream* args,
                     ActionResult* result) override;
 };
 
@@ -275,15 +394,20 @@ class Version : public Action<void> {
   virtual ~Version() {}
   std::string get_help(size_t column_width) const override;
   bool validate() override;
-  void consume_args(const ParseContext& ctx, std::list<std::string>* args,
+  void consume_args(const ParseContext& ctx, TokenStream* args,
                     ActionResult* result) override;
 };
 
-// Optional parameters provided to `add_subparsers`.
+// Optional parameters provided to `add_subparsers` or `add_parser`.
 struct SubparserOptions {
   std::string help;  //< help text used to describe the subparsers
+  std::vector<std::string> aliases;  //< alternative names for a subcommand,
+                                     //  only meaningful for `add_parser`
 };
 
+// Callback which adds arguments to a newly constructed subparser
+typedef std::function<void(Parser*)> ParserBuilder;
+
 // Implements the subparser action, which dispatches another parser
 /* Subparser actions act like the "store" action for a string type, in the
  * sense that they consume one argument (the subcommand) and store it in a
@@ -297,9 +421,6 @@ struct SubparserOptions {
  */
 class Subparsers : public StoreValue<std::string> {
  public:
-  // The type of the map that we store, mapping comman names to subparsers
-  typedef std::map<std::string, std::shared_ptr<Parser>> MapType;
-
   // These options are cached by the `Subparsers` object and passed on to
   // each parser which it constructs.
   struct Metadata {
@@ -312,27 +433,79 @@ class Subparsers : public StoreValue<std::string> {
                       //  and the main one
   };
 
+  // A subcommand registered with the action
+  /* The name and prolog of the subcommand are stored here so that help and
+   * completion can enumerate subcommands without constructing their parsers.
+   * Subcommands registered with `add_lazy_parser` construct their parser the
+   * first time it is requested, which is usually when the subcommand is
+   * selected on the command line. */
+  class Entry {
+   public:
+    Entry(const std::string& name, const SubparserOptions& opts,
+          const Metadata& meta, const ParserBuilder& builder);
+    Entry(const std::string& name, const SubparserOptions& opts,
+          const std::shared_ptr<Parser>& parser);
+
+    // Return the subcommand name
+    const std::string& get_name() const;
+
+    // Return the alternative names of the subcommand
+    const std::vector<std::string>& get_aliases() const;
+
+    // Return the prolog for the subcommand help, without constructing it
+    std::string get_prolog(size_t column_width = 0) const;
+
+    // Return true if the parser for this subcommand has been constructed
+    bool is_built() const;
+
+    // Return the parser for this subcommand, constructing (and freezing) it if
+    // needed. This is safe to call from multiple threads.
+    const std::shared_ptr<Parser>& get_parser() const;
+
+   private:
+    std::string name_;
+    std::vector<std::string> aliases_;
+    std::string prolog_;
+    Metadata meta_;
+    ParserBuilder builder_;
+
+    mutable std::once_flag build_once_;
+    mutable std::atomic<bool> built_;
+    mutable std::shared_ptr<Parser> parser_;
+  };
+
+  // The type of the list of subcommands, in registration order
+  typedef std::vector<std::unique_ptr<Entry>> EntryList;
+
   explicit Subparsers(const Metadata& meta = {});
   virtual ~Subparsers() {}
 
-  // Recursively validate this action and all subparsers
-  bool validate() override;
-
   std::string get_help(size_t column_width) const override;
 
   // Consume one argument, pass remaining args to appropriate subparser
   /* This action will consume one argument from the argument list. If that
-   * argument matches a `command` in the subparser map, then it will pass
-   * the remaining arguments to the subparser. Otherwise it is an error and
-   * it will throw. */
-  void consume_args(const ParseContext& ctx, std::list<std::string>* args,
+   * argument matches the name or alias of a command, or is a unique prefix of
+   * one, then it will pass the remaining arguments to the subparser and store
+   * the name of the command (not the alias or prefix) in the destination.
+   * Otherwise it is an error and it will throw. */
+  void consume_args(const ParseContext& ctx, TokenStream* args,
                     ActionResult* result) override;
 
-  // Convenience accessor to subparser map iterator
-  MapType::const_iterator begin() const;
+  // Iterate over subcommands in the order they were registered
+  EntryList::const_iterator begin() const;
+
+  // Iterate over subcommands in the order they were registered
+  EntryList::const_iterator end() const;
 
-  // Convenience accessor to subparser map iterator
-  MapType::const_iterator end() const;
+  // Return the subcommand matching `command` exactly, either by name or by
+  // alias, or nullptr if there is no such subcommand.
+  const Entry* find_command(const StringPiece& command) const;
+
+  // Return the subcommand which `command` matches exactly or else is a unique
+  // prefix of. `*num_matches` is set to the number of distinct subcommands
+  // matched, and nullptr is returned if that is not exactly one.
+  const Entry* match_command(const StringPiece& command,
+                             size_t* num_matches) const;
 
   // Add a new subparser associated with the given command
   /* This call will construct a new parser object using the provided options,
@@ -340,17 +513,53 @@ class Subparsers : public StoreValue<std::string> {
    * `command`.
    *
    * When this action is activated it will consume one argument from the
-   * argument list. If that argument matches `command`, then it will pass
-   * the remaining arguments to the subparser. */
+   * argument list. If that argument matches `command` (or one of
+   * `opts.aliases`), then it will pass the remaining arguments to the
+   * subparser. */
   std::shared_ptr<Parser> add_parser(const std::string& command,
                                      const SubparserOptions& opts = {});
 
+  // Add a subcommand whose parser is constructed only when it is needed
+  /* `opts.help` is used as the prolog of the subcommand, and is available
+   * for help text and completion without constructing the parser. When the
+   * subcommand is first selected a parser is constructed with the same
+   * metadata that `add_parser` would use, and `builder` is called to add its
+   * arguments. */
+  void add_lazy_parser(const std::string& command, const SubparserOptions& opts,
+                       const ParserBuilder& builder);
+
   void write_completions(const ParseContext& ctx) override;
 
  private:
-  MapType subparser_map_;  //< maps command names to parser objects
-  Metadata metadata_;      //< cache of common options used for all subparsers
-                           // constructed
+  // Entry in the index of subcommand names and aliases
+  struct NameEntry {
+    StringPiece name;  //< name or alias, referencing storage in the `Entry`
+    size_t entry_idx;  //< index of the subcommand in `entries_`
+    bool is_alias;     //< true if this is an alias rather than the name
+  };
+
+  // Append a subcommand and add its name and aliases to the index. Throws
+  // CONFIG_ERROR if any of them are already in use.
+  void add_entry(std::unique_ptr<Entry> entry);
+
+  // Add one name to the name index and hash table
+  void index_name(const StringPiece& name, size_t entry_idx, bool is_alias);
+
+  // Return a list of all the command names, in registration order
+  std::string join_names(const char* separator) const;
+
+  EntryList entries_;  //< subcommands, in registration order
+
+  // Names and aliases of all subcommands, sorted lexicographically. Used to
+  // resolve prefixes and enumerate completions.
+  std::vector<NameEntry> sorted_names_;
+
+  // Open addressing hash table of names and aliases, used for exact matches.
+  // The size is a power of two, and empty slots have an `entry_idx` of -1.
+  std::vector<NameEntry> hash_table_;
+
+  Metadata metadata_;  //< cache of common options used for all subparsers
+                       // constructed
 };
 
 }  // namespace argue
@@ -1,12 +1,19 @@
 #pragma once
 // Copyright 2018-2020 Josh Bialkowski <josh.bialkowski@gmail.com>
 
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
 #include "argue/action.h"
 #include "argue/exception.h"
 #include "argue/parse.h"
 #include "argue/util.h"
 #include "tangent/util/string_util.h"
 
+#include "argue/choice_set.tcc"
+#include "argue/parse.tcc"
 #include "argue/storage_model.tcc"
 
 namespace argue {
@@ -29,30 +36,37 @@ void Action<T>::set_default(const T& value) {
 }
 
 template <typename T>
-void Action<T>::set_default(const std::vector<T>&& value) {
-  default_.clear();
-  default_.move(value);
+void Action<T>::set_default(std::vector<T>&& value) {
+  default_ = std::move(value);
   this->has_default_ = 1;
 }
 
 template <typename T>
-void Action<T>::set_choices(const std::vector<T>&& value) {
-  choices_ = std::move(value);
-  this->has_choices_ = 1;
+void Action<T>::set_choices(std::vector<T>&& value) {
+  this->set_choices(make_choices(std::move(value)));
 }
 
 template <typename T>
 void Action<T>::set_choices(const std::vector<T>& value) {
-  choices_ = value;
-  this->has_choices_ = 1;
+  this->set_choices(make_choices(value));
 }
 
 template <typename T>
 void Action<T>::set_choices(const std::initializer_list<T>& value) {
+  this->set_choices(make_choices(value));
+}
+
+template <typename T>
+void Action<T>::set_choices(const std::shared_ptr<const ChoiceSet<T>>& value) {
   choices_ = value;
   this->has_choices_ = 1;
 }
 
+template <typename T>
+bool Action<T>::is_valid_choice(const T& value) const {
+  return !choices_ || choices_->empty() || choices_->contains(value);
+}
+
 template <typename T>
 void Action<T>::set_destination(T* destination) {
   this->set_destination(ScalarModel<T>::create(destination));
@@ -62,6 +76,7 @@ template <typename T>
 void Action<T>::set_destination(const std::shared_ptr<StorageModel<T>>& model) {
   destination_ = model;
   has_destination_ = 1;
+  this->target_type_ = TypeId();
 }
 
 template <class T>
@@ -76,21 +91,51 @@ void Action<T>::set_destination(std::vector<T, Allocator>* destination) {
   this->set_destination(VectorModel<T, Allocator>::create(destination));
 }
 
+template <class T>
+template <class Class, class Field>
+void Action<T>::set_destination(Field Class::*destination) {
+  this->set_destination(MemberPath<Class, Field>(destination));
+}
+
+template <class T>
+template <class Class, class Field>
+void Action<T>::set_destination(const MemberPath<Class, Field>& destination) {
+  this->set_destination(make_member_model<T>(destination));
+  this->target_type_ = type_id<Class>();
+}
+
 template <typename T>
 bool StoreValue<T>::is_scalar() const {
   return (this->nargs_ == ZERO_OR_ONE || this->nargs_ == EXACTLY_ONE);
 }
 
+template <typename T>
+int StoreValue<T>::get_value_count() const {
+  // NOTE(josh): a scalar with nargs='?' still requires its value, see
+  // `consume_scalar`.
+  return this->is_scalar() ? 1 : this->nargs_;
+}
+
 template <typename T>
 std::string StoreValue<T>::get_help(size_t column_width) const {
   std::list<std::string> parts;
   if (this->has_help_) {
     parts.push_back(wrap(this->help_, column_width));
   }
-  if (this->has_choices_ && !this->choices_.empty()) {
+  std::string choices;
+  if (this->choices_ && !this->choices_->empty()) {
+    choices = join_values(this->choices_->values());
+  } else {
+    for_each_enum_name<T>("", [&choices](const StringPiece& name) {
+      if (!choices.empty()) {
+        choices += ", ";
+      }
+      choices.append(name.data(), name.size());
+    });
+  }
+  if (!choices.empty()) {
     parts.push_back(
-        wrap(fmt::format("choices=[{}]", string::join(this->choices_, ", ")),
-             column_width));
+        wrap(fmt::format("choices=[{}]", choices), column_width));
   }
   // if (this->has_default_ && !this->default_.empty()) {
   //   parts.push_back(
@@ -119,22 +164,38 @@ bool StoreValue<T>::validate() {
     // << `store` action must either be required or have a default value set;
   }
 
-  if (this->has_default_) {
-    if (this->is_scalar()) {
-      this->destination_->assign(this->default_[0]);
-    } else {
-      this->destination_->init(this->default_.size());
-      for (const auto& elem : this->default_) {
-        this->destination_->append(elem);
-      }
+  return true;
+}
+
+template <typename T>
+void StoreValue<T>::apply_defaults(const ParseContext& ctx) {
+  if (this->has_default_ && !this->destination_->is_streaming()) {
+    this->write_defaults(ctx);
+  }
+}
+
+template <typename T>
+void StoreValue<T>::apply_unused_defaults(const ParseContext& ctx) {
+  if (this->has_default_ && this->destination_->is_streaming()) {
+    this->write_defaults(ctx);
+  }
+}
+
+template <typename T>
+void StoreValue<T>::write_defaults(const ParseContext& ctx) {
+  void* target = ctx.target.get();
+  if (this->is_scalar()) {
+    this->destination_->assign(target, this->default_[0]);
+  } else {
+    this->destination_->init(target, this->default_.size());
+    for (const auto& elem : this->default_) {
+      this->destination_->append(target, elem);
     }
   }
-  return true;
 }
 
 template <typename T>
-void StoreValue<T>::consume_args(const ParseContext& ctx,
-                                 std::list<std::string>* args,
+void StoreValue<T>::consume_args(const ParseContext& ctx, TokenStream* args,
                                  ActionResult* result) {
   if (this->is_scalar()) {
     this->consume_scalar(ctx, args, result);
@@ -144,34 +205,52 @@ void StoreValue<T>::consume_args(const ParseContext& ctx,
 }
 
 template <typename T>
-void StoreValue<T>::consume_scalar(const ParseContext& ctx,
-                                   std::list<std::string>* args,
+void StoreValue<T>::consume_scalar(const ParseContext& ctx, TokenStream* args,
                                    ActionResult* result) {
-  ArgType arg_type = get_arg_type(args->front());
-  if (arg_type == POSITIONAL) {
-    T value{};
-    if (parse(args->front(), &value)) {
-      result->code = PARSE_EXCEPTION;
-      return;
-    }
-    if (this->choices_.size() > 0) {
-      ARGUE_ASSERT(INPUT_ERROR, has_choice(this->choices_, value))
-          << fmt::format("Invalid value '{}' choose from '{}'", args->front());
-    }
-    this->destination_->assign(value);
-    args->pop_front();
-  } else {
-    ARGUE_THROW(INPUT_ERROR) << fmt::format(
-        "Expected a value but instead got a flag {}", ctx.arg.c_str());
+  if (args->empty()) {
+    result->code = fail_parse(
+        ctx, args->index(),
+        fmt::format("Expected a value for {}", ctx.arg.to_string()));
+    return;
+  }
+
+  ArgType arg_type = args->front_type();
+  if (arg_type != POSITIONAL) {
+    result->code = fail_parse(
+        ctx, args->index(),
+        fmt::format("Expected a value but instead got a flag {}",
+                    args->front().to_string()));
+    return;
+  }
+
+  this->complete_value(ctx, args);
+  T value{};
+  if (parse_token(args->front(), &value)) {
+    result->code = fail_parse(
+        ctx, args->index(),
+        fmt::format("Invalid value '{}'", args->front().to_string()));
+    return;
+  }
+  if (!this->is_valid_choice(value)) {
+    result->code = fail_parse(
+        ctx, args->index(),
+        fmt::format("Invalid value '{}' choose from '{}'",
+                    args->front().to_string(),
+                    join_values(this->choices_->values())));
+    return;
   }
+  this->destination_->assign(ctx.target.get(), std::move(value));
+  args->pop_front();
 }
 
 template <typename T>
-void StoreValue<T>::consume_list(const ParseContext& ctx,
-                                 std::list<std::string>* args,
+void StoreValue<T>::consume_list(const ParseContext& ctx, TokenStream* args,
                                  ActionResult* result) {
   size_t min_args = 0;
-  size_t max_args = 0xffff;
+  // NOTE(josh): there is no limit on the number of arguments consumed by
+  // '+' or '*', a response file may supply millions of them.
+  const size_t kUnbounded = std::numeric_limits<size_t>::max();
+  size_t max_args = kUnbounded;
   if (this->nargs_ < 1) {
     switch (this->nargs_) {
       case EXACTLY_ONE:
@@ -200,42 +279,80 @@ void StoreValue<T>::consume_list(const ParseContext& ctx,
     max_args = this->nargs_;
   }
 
-  if (max_args < 0xffff) {
-    this->destination_->init(max_args);
-  } else {
-    this->destination_->init(1);
-  }
+  // NOTE(josh): the values consumed are exactly the run of positionals at the
+  // front of the stream (up to `max_args`) so the destination is sized once.
+  void* target = ctx.target.get();
+  this->destination_->init(target,
+                           std::min(max_args, args->positional_run()));
 
   T value;
   size_t arg_idx = 0;
   for (arg_idx = 0; arg_idx < max_args && !args->empty(); arg_idx++) {
-    ArgType arg_type = get_arg_type(args->front());
-    if (arg_type == POSITIONAL) {
-      if (parse(args->front(), &value)) {
-        result->code = PARSE_EXCEPTION;
-        return;
-      }
-
-      if (this->choices_.size() > 0) {
-        ARGUE_ASSERT(INPUT_ERROR, has_choice(this->choices_, value))
-            << fmt::format("Invalid value '{}' choose from '{}'", args->front(),
-                           string::join(this->choices_));
-      }
-      args->pop_front();
-      if (this->has_destination_) {
-        this->destination_->append(value);
-      }
+    ArgType arg_type = args->front_type();
+    if (arg_type != POSITIONAL) {
+      break;
+    }
+    this->complete_value(ctx, args);
+    if (parse_token(args->front(), &value)) {
+      result->code = fail_parse(
+          ctx, args->index(),
+          fmt::format("Invalid value '{}'", args->front().to_string()));
+      return;
+    }
+    if (!this->is_valid_choice(value)) {
+      result->code = fail_parse(
+          ctx, args->index(),
+          fmt::format("Invalid value '{}' choose from '{}'",
+                      args->front().to_string(),
+                      join_values(this->choices_->values())));
+      return;
+    }
+    args->pop_front();
+    if (this->has_destination_) {
+      this->destination_->append(target, std::move(value));
+    }
+  }
 
+  if (arg_idx < min_args) {
+    if (args->empty()) {
+      result->code = fail_parse(
+          ctx, args->index(),
+          fmt::format("Expected {} arguments but only got {}", min_args,
+                      arg_idx));
     } else {
-      ARGUE_ASSERT(INPUT_ERROR, arg_idx >= min_args)
-          << fmt::format("Expected {} arguments but only got {} before flag {}",
-                         min_args, arg_idx + 1, ctx.arg.c_str());
+      result->code = fail_parse(
+          ctx, args->index(),
+          fmt::format("Expected {} arguments but only got {} before flag {}",
+                      min_args, arg_idx, args->front().to_string()));
     }
   }
+}
+
+template <typename T>
+void StoreValue<T>::write_completions(const ParseContext& ctx) {
+  auto write = [&ctx](const StringPiece& name) {
+    (*ctx.auto_complete.debug) << name << "\n";
+    std::cout << name << ctx.auto_complete.ifs;
+  };
+  if (this->choices_) {
+    this->choices_->for_each_completion(ctx.arg, write);
+  } else {
+    for_each_enum_name<T>(ctx.arg, write);
+  }
+}
 
-  ARGUE_ASSERT(INPUT_ERROR, arg_idx >= min_args)
-      << fmt::format("Expected {} arguments but only got {}", min_args,
-                     arg_idx + 1, ctx.arg.c_str());
+template <typename T>
+void StoreValue<T>::complete_value(const ParseContext& ctx,
+                                   TokenStream* args) {
+  if (!ctx.auto_complete.active ||
+      ctx.auto_complete.comp_word != args->index()) {
+    return;
+  }
+  ParseContext comp_ctx{ctx};
+  comp_ctx.arg = args->front();
+  this->write_completions(comp_ctx);
+  std::cout.flush();
+  exit(0);
 }
 
 template <typename T>
@@ -245,6 +362,11 @@ void StoreConst<T>::set_const(const T& value) {
   this->has_const_ = 1;
 }
 
+template <typename T>
+int StoreConst<T>::get_value_count() const {
+  return 0;
+}
+
 template <typename T>
 bool StoreConst<T>::validate() {
   ARGUE_ASSERT(CONFIG_ERROR, this->has_const_)
@@ -256,30 +378,20 @@ bool StoreConst<T>::validate() {
   // ARGUE_ASSERT(spec.default_.is_set)
   // << "default_= is required for action='store_const'";
 
-  if (this->has_default_) {
-    if (this->is_scalar()) {
-      this->destination_->assign(this->default_[0]);
-    } else {
-      this->destination_->init(this->default_.size());
-      for (const auto& elem : this->default_) {
-        this->destination_->append(elem);
-      }
-    }
-  }
   return true;
 }
 
 template <typename T>
-void StoreConst<T>::consume_args(const ParseContext& ctx,
-                                 std::list<std::string>* args,
+void StoreConst<T>::consume_args(const ParseContext& ctx, TokenStream* args,
                                  ActionResult* result) {
   if (this->has_const_) {
+    void* target = ctx.target.get();
     if (this->is_scalar()) {
-      this->destination_->assign(this->const_[0]);
+      this->destination_->assign(target, this->const_[0]);
     } else {
-      this->destination_->init(this->const_.size());
+      this->destination_->init(target, this->const_.size());
       for (const auto& elem : this->const_) {
-        this->destination_->append(elem);
+        this->destination_->append(target, elem);
       }
     }
   }
@@ -2,5 +2,6 @@
 set(_bindir @PACKAGE_CMAKE_INSTALL_BINDIR@)
 
 include(${CMAKE_CURRENT_LIST_DIR}/argue-targets.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/help_artifacts.cmake)
 check_required_components(argue)
 
@@ -2,15 +2,20 @@
 // Copyright 2018 Josh Bialkowski <josh.bialkowski@gmail.com>
 
 #include "argue/action.h"
+#include "argue/choice_set.h"
+#include "argue/enum_table.h"
 #include "argue/exception.h"
 #include "argue/keywords.h"
 #include "argue/kwargs.h"
 #include "argue/parse.h"
 #include "argue/parser.h"
+#include "argue/response_file.h"
 #include "argue/storage_model.h"
+#include "argue/token_stream.h"
 #include "argue/util.h"
 
 #include "argue/action.tcc"
+#include "argue/choice_set.tcc"
 #include "argue/keywords.tcc"
 #include "argue/kwargs.tcc"
 #include "argue/parse.tcc"
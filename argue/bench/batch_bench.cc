@@ -0,0 +1,139 @@
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+//
+// Measure the throughput of `Parser::parse_batch` over a synthetic job-spec
+// file, for each number of worker threads from one up to the number of
+// hardware threads.
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "argue/argue.h"
+#include "fmt/format.h"
+
+namespace {
+
+// Options for one job of the job-spec file
+struct JobOptions {
+  std::string command;
+  int priority = 0;
+  int retries = 0;
+  bool verbose = false;
+  std::vector<std::string> inputs;
+  struct Run {
+    std::string output;
+  } run;
+};
+
+// Build the schema for one line of the job-spec file. Every destination is a
+// member of JobOptions so that the workers can share the parser.
+void build_job_parser(argue::Parser* parser) {
+  using namespace argue::keywords;  // NOLINT
+  parser->add_argument("-p", "--priority", dest = &JobOptions::priority,
+                       choices = {0, 1, 2, 3});
+  parser->add_argument("-r", "--retries", dest = &JobOptions::retries);
+  parser->add_argument("-v", "--verbose", action = "store_true",
+                       dest = &JobOptions::verbose);
+  auto subparsers = parser->add_subparsers("command", &JobOptions::command);
+  auto run = subparsers->add_parser("run");
+  run->add_argument(
+      "-o", "--output",
+      dest = argue::member(&JobOptions::run, &JobOptions::Run::output));
+  run->add_argument("inputs", nargs = "+", dest = &JobOptions::inputs);
+  auto check = subparsers->add_parser("check");
+  check->add_argument("inputs", nargs = "*", dest = &JobOptions::inputs);
+  parser->freeze();
+}
+
+// Generate `num_lines` command lines, every line is valid
+std::vector<std::vector<std::string>> make_job_lines(size_t num_lines) {
+  std::vector<std::vector<std::string>> lines;
+  lines.reserve(num_lines);
+  for (size_t idx = 0; idx < num_lines; ++idx) {
+    std::vector<std::string> line = {"--priority", std::to_string(idx % 4),
+                                     "-r", std::to_string(idx % 7)};
+    if (idx % 3 == 0) {
+      line.emplace_back("-v");
+    }
+    if (idx % 5 == 0) {
+      line.emplace_back("check");
+    } else {
+      line.emplace_back("run");
+      line.emplace_back("--output");
+      line.emplace_back(fmt::format("/data/out/job_{:08d}.out", idx));
+    }
+    for (size_t jdx = 0; jdx < 1 + idx % 8; ++jdx) {
+      line.emplace_back(
+          fmt::format("/data/in/shard_{:04d}/part_{:06d}.rec", jdx, idx));
+    }
+    lines.emplace_back(std::move(line));
+  }
+  return lines;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t num_lines = 100000;
+  size_t max_threads = std::thread::hardware_concurrency();
+  size_t iterations = 3;
+
+  argue::Parser parser({
+      .add_help = true,
+      .add_version = false,
+      .name = "argue-batch_bench",
+  });
+
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-n", "--num-lines", dest = &num_lines,
+                      help = "number of command lines in the batch");
+  parser.add_argument("-t", "--max-threads", dest = &max_threads,
+                      help = "largest number of worker threads to measure");
+  parser.add_argument("-i", "--iterations", dest = &iterations,
+                      help = "number of batches to parse per thread count");
+
+  int parse_result = parser.parse_args(argc, argv);
+  switch (parse_result) {
+    case argue::PARSE_ABORTED:
+      return 0;
+    case argue::PARSE_EXCEPTION:
+      return 1;
+    case argue::PARSE_FINISHED:
+      break;
+  }
+  if (max_threads < 1) {
+    max_threads = 1;
+  }
+
+  argue::Parser job_parser({.add_help = false, .name = "job"});
+  build_job_parser(&job_parser);
+  std::vector<std::vector<std::string>> lines = make_job_lines(num_lines);
+  std::vector<JobOptions> jobs;
+
+  std::cout << fmt::format("{:>8} {:>14} {:>10}\n", "threads", "lines/s",
+                           "speedup");
+  double baseline = 0;
+  for (size_t num_threads = 1; num_threads <= max_threads; ++num_threads) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t iter = 0; iter < iterations; ++iter) {
+      std::vector<argue::BatchResult> results =
+          job_parser.parse_batch(lines, &jobs, num_threads);
+      for (const argue::BatchResult& result : results) {
+        if (result.result != argue::PARSE_FINISHED) {
+          std::cerr << "Parse failed: " << result.error.message << "\n";
+          return 1;
+        }
+      }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    double lines_per_second = (num_lines * iterations) / seconds;
+    if (num_threads == 1) {
+      baseline = lines_per_second;
+    }
+    std::cout << fmt::format("{:>8} {:>14.0f} {:>10.2f}\n", num_threads,
+                             lines_per_second, lines_per_second / baseline);
+  }
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+//
+// Compare the cost of parsing a large command line directly out of `argv`
+// against first copying it into a list of strings, which is what the parser
+// used to do internally.
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "argue/argue.h"
+#include "fmt/format.h"
+
+namespace {
+
+// A synthetic command line with a couple of flags and a long tail of
+// positional file names (long enough to defeat the small string optimization).
+struct CommandLine {
+  std::vector<std::string> storage;
+  std::vector<char*> argv;
+
+  explicit CommandLine(size_t num_files) {
+    storage.emplace_back("parse-bench");
+    storage.emplace_back("--jobs");
+    storage.emplace_back("8");
+    storage.emplace_back("-v");
+    for (size_t idx = 0; idx < num_files; ++idx) {
+      storage.emplace_back(fmt::format(
+          "/home/user/project/src/module_{:04d}/source_file_{:06d}.cc",
+          idx % 1000, idx));
+    }
+    for (std::string& arg : storage) {
+      argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+  }
+
+  int argc() const {
+    return static_cast<int>(storage.size());
+  }
+};
+
+// The program under test: the destinations are reset on every parse.
+struct Program {
+  int jobs = 1;
+  bool verbose = false;
+  std::vector<std::string> files;
+  argue::Parser parser;
+
+  Program() : parser({.add_help = false, .name = "parse-bench"}) {
+    using namespace argue::keywords;  // NOLINT
+    parser.add_argument("-j", "--jobs", dest = &jobs);
+    parser.add_argument("-v", "--verbose", action = "store_true",
+                        dest = &verbose);
+    parser.add_argument("files", nargs = "*", dest = &files);
+  }
+};
+
+int parse_from_argv(const CommandLine& cmd) {
+  Program program;
+  int result = program.parser.parse_args(
+      cmd.argc(), const_cast<char**>(cmd.argv.data()));
+  return result == argue::PARSE_FINISHED ? program.files.size() : -1;
+}
+
+int parse_from_list(const CommandLine& cmd) {
+  Program program;
+  std::list<std::string> args;
+  for (int idx = 1; idx < cmd.argc(); ++idx) {
+    args.emplace_back(cmd.argv[idx]);
+  }
+  int result = program.parser.parse_args(&args);
+  return result == argue::PARSE_FINISHED ? program.files.size() : -1;
+}
+
+template <typename Fn>
+double time_per_parse(const CommandLine& cmd, size_t iterations, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t iter = 0; iter < iterations; ++iter) {
+    if (fn(cmd) < 0) {
+      std::cerr << "Parse failed\n";
+      return -1;
+    }
+  }
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(stop - start).count() /
+         iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t num_files = 10000;
+  size_t iterations = 100;
+
+  argue::Parser parser({
+      .add_help = true,
+      .add_version = false,
+      .name = "argue-parse_bench",
+  });
+
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-n", "--num-files", dest = &num_files,
+                      help = "number of positional arguments to parse");
+  parser.add_argument("-i", "--iterations", dest = &iterations,
+                      help = "number of times to parse the command line");
+
+  int parse_result = parser.parse_args(argc, argv);
+  switch (parse_result) {
+    case argue::PARSE_ABORTED:
+      return 0;
+    case argue::PARSE_EXCEPTION:
+      return 1;
+    case argue::PARSE_FINISHED:
+      break;
+  }
+
+  CommandLine cmd{num_files};
+  // Warm up the allocator so that neither path pays for first-touch
+  parse_from_argv(cmd);
+
+  double argv_us = time_per_parse(cmd, iterations, parse_from_argv);
+  double list_us = time_per_parse(cmd, iterations, parse_from_list);
+  std::cout << fmt::format("{:>12} {:>14}\n", "path", "us/parse");
+  std::cout << fmt::format("{:>12} {:>14.1f}\n", "argv-view", argv_us);
+  std::cout << fmt::format("{:>12} {:>14.1f}\n", "list-copy", list_us);
+  return 0;
+}
@@ -0,0 +1,126 @@
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+//
+// Compare the cost of parsing floating point arguments with `argue::parse`
+// against the standard library conversions.
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+
+#include "argue/argue.h"
+#include "fmt/format.h"
+
+namespace {
+
+// Random doubles, uniform in their exponent, printed with enough digits to
+// round trip
+std::vector<std::string> make_queries(size_t count) {
+  std::mt19937_64 rng{1234};
+  std::uniform_real_distribution<double> mantissa{-1.0, 1.0};
+  std::uniform_int_distribution<int> exponent{-300, 300};
+  std::vector<std::string> queries;
+  queries.reserve(count);
+  for (size_t idx = 0; idx < count; ++idx) {
+    double value = std::ldexp(mantissa(rng), exponent(rng));
+    queries.emplace_back(fmt::format("{:.17g}", value));
+  }
+  return queries;
+}
+
+// Return nanoseconds per call of `fn` over all of `queries`, repeated
+// `iterations` times. The sum of the parsed values is written to `checksum`
+// so the compiler cannot discard the work.
+template <typename Fn>
+double time_per_query(const std::vector<std::string>& queries,
+                      size_t iterations, double* checksum, Fn fn) {
+  double sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t iter = 0; iter < iterations; ++iter) {
+    for (const std::string& query : queries) {
+      sum += fn(query);
+    }
+  }
+  auto stop = std::chrono::steady_clock::now();
+  *checksum = sum;
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+         (iterations * queries.size());
+}
+
+double parse_argue(const std::string& query) {
+  double value = 0;
+  argue::parse(argue::StringPiece(query), &value);
+  return value;
+}
+
+double parse_strtod(const std::string& query) {
+  return std::strtod(query.c_str(), nullptr);
+}
+
+#if __cplusplus >= 201703L
+double parse_from_chars(const std::string& query) {
+  double value = 0;
+  std::from_chars(query.data(), query.data() + query.size(), value);
+  return value;
+}
+#endif
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t num_queries = 100000;
+  size_t iterations = 20;
+
+  argue::Parser parser({
+      .add_help = true,
+      .add_version = false,
+      .name = "argue-parse_float_bench",
+  });
+
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-n", "--num-queries", dest = &num_queries,
+                      help = "number of distinct numbers to parse");
+  parser.add_argument("-i", "--iterations", dest = &iterations,
+                      help = "number of times to parse each number");
+
+  int parse_result = parser.parse_args(argc, argv);
+  switch (parse_result) {
+    case argue::PARSE_ABORTED:
+      return 0;
+    case argue::PARSE_EXCEPTION:
+      return 1;
+    case argue::PARSE_FINISHED:
+      break;
+  }
+
+  std::vector<std::string> queries = make_queries(num_queries);
+  double expect = 0;
+  double checksum = 0;
+
+  std::cout << fmt::format("{:>12} {:>10}\n", "parser", "ns/parse");
+  double argue_ns = time_per_query(queries, iterations, &expect, parse_argue);
+  std::cout << fmt::format("{:>12} {:>10.1f}\n", "argue", argue_ns);
+  double strtod_ns =
+      time_per_query(queries, iterations, &checksum, parse_strtod);
+  std::cout << fmt::format("{:>12} {:>10.1f}\n", "strtod", strtod_ns);
+  if (checksum != expect) {
+    std::cerr << "strtod disagrees with argue::parse\n";
+    return 1;
+  }
+#if __cplusplus >= 201703L
+  double from_chars_ns =
+      time_per_query(queries, iterations, &checksum, parse_from_chars);
+  std::cout << fmt::format("{:>12} {:>10.1f}\n", "from_chars", from_chars_ns);
+  if (checksum != expect) {
+    std::cerr << "from_chars disagrees with argue::parse\n";
+    return 1;
+  }
+#endif
+  return 0;
+}
@@ -1,19 +1,25 @@
 // Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include <elf.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <cstdlib>
 #include <functional>
+#include <iostream>
 
 #include <libelf.h>
 #include <loki/ScopeGuard.h>
 
 #include "argue/argue.h"
+#include "argue/can_complete.h"
 
 struct ProgramOptions {
   std::string filepath;
+  bool no_cache;
+  bool print_spec;
 };
 
 enum ElfClass { ELF32 = 1, ELF64 = 2 };
@@ -84,7 +90,10 @@ int has_magic_symbol(Elf* elf) {
   return 1;
 }
 
-int file_is_magic_elf(const std::string filepath) {
+// Return zero if `filepath` is an ELF program which uses argue, filling
+// `notes` with what was found in its argue notes.
+int file_is_magic_elf(const std::string filepath,
+                      argue::can_complete::ArgueNotes* notes) {
   int fd = open(filepath.c_str(), O_RDONLY);
   if (fd == -1) {
     return 1;
@@ -97,10 +106,14 @@ int file_is_magic_elf(const std::string filepath) {
     // Can't stat the file
     return 1;
   }
+  if (statbuf.st_size < EI_NIDENT) {
+    // Too small to be an ELF file
+    return 1;
+  }
 
   void* mem =
       mmap(nullptr, statbuf.st_size, PROT_READ, MAP_SHARED, fd, /*offset=*/0);
-  if (!mem) {
+  if (mem == MAP_FAILED) {
     // Can't map the file
     return 1;
   }
@@ -113,10 +126,17 @@ int file_is_magic_elf(const std::string filepath) {
     return 1;
   }
 
-  Elf* elf = elf_memory(image, statbuf.st_size);
-  ElfClass elf_class = static_cast<ElfClass>(image[EI_CLASS]);
+  // NOTE(josh): files of a different byte order than this program fall back
+  // to libelf
+  if (argue::can_complete::find_argue_notes(image, statbuf.st_size, notes) &&
+      notes->found) {
+    return 0;
+  }
 
-  switch (elf_class) {
+  // Programs linked against older versions of argue have no note, only the
+  // sentinel symbol, and only if they are not stripped.
+  Elf* elf = elf_memory(image, statbuf.st_size);
+  switch (static_cast<ElfClass>(image[EI_CLASS])) {
     case ELF32:
       return has_magic_symbol<Traits32>(elf);
     case ELF64:
@@ -139,12 +159,28 @@ this support, it must include a particular symbol ARGUE_AUTOCOMPLETE_ME in
 it's symbol table.
 
 This program will exit with status code zero if the provided file is a valid
-ELF program file which includes the sentinel symbol in it's symbol table.
+ELF program file which includes the `.note.argue` note section, or the sentinel
+symbol in it's symbol table (for programs linked against older versions of
+argue).
+
+The verdict is cached under $XDG_CACHE_HOME/argue/can-complete/v2 (or
+~/.cache/argue/can-complete/v2) for as long as the file keeps the same device,
+inode, size and modification time, so checking the same program again costs
+one stat.
 )prolog";
 
   argue::Parser parser{meta};
   ProgramOptions progopts{};
   parser.add_argument("filepath", &progopts.filepath);
+  parser.add_argument("--no-cache", &progopts.no_cache,
+                      {.action = "store_true",
+                       .help = "Neither read nor write the cached verdict"});
+  parser.add_argument(
+      "--print-spec", &progopts.print_spec,
+      {.action = "store_true",
+       .help = "Print the completion spec embedded in the program, if any, "
+               "instead of checking it. Exits non-zero if there is none, or "
+               "if it is not in the format of this version of argue."});
 
   int parse_result = parser.parse_args(argc, argv);
   switch (parse_result) {
@@ -156,5 +192,40 @@ ELF program file which includes the sentinel symbol in it's symbol table.
       break;
   }
 
-  exit(file_is_magic_elf(progopts.filepath));
+  argue::can_complete::ArgueNotes notes{};
+  if (progopts.print_spec) {
+    if (file_is_magic_elf(progopts.filepath, &notes) ||
+        !argue::can_complete::has_supported_spec(notes)) {
+      exit(1);
+    }
+    std::cout << notes.completion_spec;
+    std::cout.flush();
+    exit(0);
+  }
+
+  struct stat statbuf {};
+  if (stat(progopts.filepath.c_str(), &statbuf)) {
+    exit(1);
+  }
+
+  namespace cache = argue::can_complete;
+  std::string cache_path;
+  if (!progopts.no_cache) {
+    std::string cache_dir = cache::get_cache_dir();
+    if (!cache_dir.empty()) {
+      cache_path = cache_dir + "/" + cache::get_cache_name(progopts.filepath);
+    }
+  }
+  std::string key = cache::get_cache_key(statbuf);
+  int verdict = 1;
+  if (!cache_path.empty() &&
+      cache::read_cached_verdict(cache_path, key, &verdict)) {
+    exit(verdict);
+  }
+
+  verdict = file_is_magic_elf(progopts.filepath, &notes);
+  if (!cache_path.empty()) {
+    cache::write_cached_verdict(cache_path, key, verdict);
+  }
+  exit(verdict);
 }
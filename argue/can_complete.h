@@ -0,0 +1,96 @@
+#pragma once
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+
+#include <sys/stat.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Implementation of the `argue-can-complete` program, kept out of its main
+// translation unit so that it can be tested.
+
+namespace argue {
+namespace can_complete {
+
+// =============================================================================
+//                               ELF Notes
+// =============================================================================
+
+// What was found in the argue notes of a program, see "argue/elf_note.h"
+struct ArgueNotes {
+  bool found;                   //< true if the program has any argue note
+  std::string spec_version;     //< descriptor of the capability note, if any
+  std::string completion_spec;  //< the embedded completion spec, if any
+};
+
+// Read the notes in `size` bytes at `offset` of the image, aligned to `align`
+// bytes, and add those owned by argue to `notes`.
+/* Each note is a header of three words followed by the name and then the
+ * descriptor. As in the gABI (and glibc), the descriptor starts at the first
+ * multiple of `align` after the name, and the next note at the first multiple
+ * of `align` after the descriptor, both relative to the start of the notes.
+ * Reading stops at the first note which does not fit. */
+void read_notes(const char* image, size_t image_size, uint64_t offset,
+                uint64_t size, uint64_t align, ArgueNotes* notes);
+
+// Find the argue notes of the ELF image through its program headers, or if
+// there are none there (e.g. in an object file) through its section headers.
+// Returns false if the image is not an ELF file which can be read in place,
+// i.e. of the same byte order as this program.
+/* This reads O(sections) headers, and nothing that `strip` removes. Headers
+ * and notes which lie outside of the `image_size` bytes of the image are
+ * ignored. */
+bool find_argue_notes(const char* image, size_t image_size, ArgueNotes* notes);
+
+// Return true if `notes` include an embedded completion spec in the format
+// that this version of argue writes (and its completion script reads). The
+// version in the capability note, if there is one (there isn't in programs
+// linked with libargue.so), and on the first line of the spec must both be
+// `kCompletionSpecVersion`.
+bool has_supported_spec(const ArgueNotes& notes);
+
+// =============================================================================
+//                              Verdict Cache
+// =============================================================================
+
+/* The verdict for a program is cached in a file named after the program's
+ * canonical path, holding the single line `<key> <status>`. The bash completion
+ * script reads and writes the same files, so the layout must match
+ * `__argue_can_complete`. */
+
+// Version of the cache layout. This is bumped whenever the key or the meaning
+// of a verdict changes, so that verdicts written by older versions (e.g. that
+// a stripped argue program can't complete) are not reused.
+static const char kCacheVersion[] = "v2";
+
+// Return the directory holding the cached verdicts, under $XDG_CACHE_HOME (or
+// ~/.cache) and versioned by `kCacheVersion`, or an empty string if there is
+// no cache directory.
+std::string get_cache_dir();
+
+// Return the name of the file in the cache directory for `filepath`. This is
+// the canonical path (see realpath(3)) of the file with '%' and '/' percent
+// encoded, so that distinct paths never share a file.
+std::string get_cache_name(const std::string& filepath);
+
+// Return the key of the cached verdict for a file with the given status. The
+// verdict is reused as long as the file at the same path has the same device,
+// inode, size and mtime.
+std::string get_cache_key(const struct stat& statbuf);
+
+// Read the verdict cached at `cache_path` into `verdict`. Returns false if
+// there is no verdict cached for `key`.
+bool read_cached_verdict(const std::string& cache_path, const std::string& key,
+                         int* verdict);
+
+// Create `dirpath` and any missing parents. Returns false on failure.
+bool make_dirs(const std::string& dirpath);
+
+// Write `verdict` to the cache at `cache_path`. Failure is not an error, the
+// verdict is just computed again next time.
+void write_cached_verdict(const std::string& cache_path,
+                          const std::string& key, int verdict);
+
+}  // namespace can_complete
+}  // namespace argue
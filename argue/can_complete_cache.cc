@@ -0,0 +1,117 @@
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include <fmt/format.h>
+
+#include "argue/can_complete.h"
+
+namespace argue {
+namespace can_complete {
+
+std::string get_cache_dir() {
+  std::string cache_dir;
+  const char* value = getenv("XDG_CACHE_HOME");
+  if (value && value[0]) {
+    cache_dir = value;
+  } else {
+    value = getenv("HOME");
+    if (!value || !value[0]) {
+      return "";
+    }
+    cache_dir = std::string(value) + "/.cache";
+  }
+  return cache_dir + "/argue/can-complete/" + kCacheVersion;
+}
+
+std::string get_cache_name(const std::string& filepath) {
+  // NOTE(josh): a path which can't be resolved is used as given. It can only
+  // mean that the file is gone, and its key won't match anything anyway.
+  char resolved[PATH_MAX];
+  std::string path = filepath;
+  if (realpath(filepath.c_str(), resolved)) {
+    path = resolved;
+  }
+
+  std::string name;
+  name.reserve(path.size());
+  for (char c : path) {
+    switch (c) {
+      case '%':
+        name += "%25";
+        break;
+      case '/':
+        name += "%2F";
+        break;
+      default:
+        name.push_back(c);
+    }
+  }
+  return name;
+}
+
+std::string get_cache_key(const struct stat& statbuf) {
+  return fmt::format("{} {} {} {}", statbuf.st_dev, statbuf.st_ino,
+                     statbuf.st_size, statbuf.st_mtime);
+}
+
+bool read_cached_verdict(const std::string& cache_path, const std::string& key,
+                         int* verdict) {
+  std::ifstream infile{cache_path};
+  std::string line;
+  if (!std::getline(infile, line)) {
+    return false;
+  }
+  if (line.size() != key.size() + 2 || line.compare(0, key.size(), key) != 0 ||
+      line[key.size()] != ' ') {
+    return false;
+  }
+  char status = line[key.size() + 1];
+  if (status != '0' && status != '1') {
+    return false;
+  }
+  *verdict = status - '0';
+  return true;
+}
+
+bool make_dirs(const std::string& dirpath) {
+  for (size_t pos = dirpath.find('/', 1); pos != std::string::npos;
+       pos = dirpath.find('/', pos + 1)) {
+    if (mkdir(dirpath.substr(0, pos).c_str(), 0755) && errno != EEXIST) {
+      return false;
+    }
+  }
+  return mkdir(dirpath.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+void write_cached_verdict(const std::string& cache_path,
+                          const std::string& key, int verdict) {
+  size_t slash = cache_path.rfind('/');
+  if (slash == std::string::npos || !make_dirs(cache_path.substr(0, slash))) {
+    return;
+  }
+  // NOTE(josh): written to a temporary and renamed into place so that a
+  // concurrent reader never sees a partial line.
+  std::string temp_path = fmt::format("{}.{}", cache_path, getpid());
+  {
+    std::ofstream outfile{temp_path};
+    outfile << key << " " << verdict << "\n";
+    if (!outfile.good()) {
+      unlink(temp_path.c_str());
+      return;
+    }
+  }
+  if (rename(temp_path.c_str(), cache_path.c_str())) {
+    unlink(temp_path.c_str());
+  }
+}
+
+}  // namespace can_complete
+}  // namespace argue
@@ -0,0 +1,160 @@
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include <elf.h>
+
+#include <cstring>
+
+#include <fmt/format.h>
+
+#include "argue/can_complete.h"
+#include "argue/elf_note.h"
+
+namespace argue {
+namespace can_complete {
+
+namespace {
+
+struct Headers32 {
+  typedef Elf32_Ehdr Ehdr;
+  typedef Elf32_Phdr Phdr;
+  typedef Elf32_Shdr Shdr;
+};
+
+struct Headers64 {
+  typedef Elf64_Ehdr Ehdr;
+  typedef Elf64_Phdr Phdr;
+  typedef Elf64_Shdr Shdr;
+};
+
+// Implementation of `find_argue_notes()` for one ELF class
+template <class Headers>
+void find_notes(const char* image, size_t image_size, ArgueNotes* notes) {
+  typedef typename Headers::Ehdr Ehdr;
+  typedef typename Headers::Phdr Phdr;
+  typedef typename Headers::Shdr Shdr;
+
+  Ehdr ehdr;
+  if (image_size < sizeof(ehdr)) {
+    return;
+  }
+  std::memcpy(&ehdr, image, sizeof(ehdr));
+
+  if (ehdr.e_phoff < image_size && ehdr.e_phentsize == sizeof(Phdr) &&
+      ehdr.e_phnum <= (image_size - ehdr.e_phoff) / sizeof(Phdr)) {
+    for (size_t idx = 0; idx < ehdr.e_phnum; ++idx) {
+      Phdr phdr;
+      std::memcpy(&phdr, image + ehdr.e_phoff + idx * sizeof(Phdr),
+                  sizeof(phdr));
+      if (phdr.p_type == PT_NOTE) {
+        read_notes(image, image_size, phdr.p_offset, phdr.p_filesz,
+                   phdr.p_align, notes);
+      }
+    }
+  }
+  if (notes->found) {
+    return;
+  }
+
+  if (ehdr.e_shoff < image_size && ehdr.e_shentsize == sizeof(Shdr) &&
+      ehdr.e_shnum <= (image_size - ehdr.e_shoff) / sizeof(Shdr)) {
+    for (size_t idx = 0; idx < ehdr.e_shnum; ++idx) {
+      Shdr shdr;
+      std::memcpy(&shdr, image + ehdr.e_shoff + idx * sizeof(Shdr),
+                  sizeof(shdr));
+      if (shdr.sh_type == SHT_NOTE) {
+        read_notes(image, image_size, shdr.sh_offset, shdr.sh_size,
+                   shdr.sh_addralign, notes);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void read_notes(const char* image, size_t image_size, uint64_t offset,
+                uint64_t size, uint64_t align, ArgueNotes* notes) {
+  if (offset > image_size || size > image_size - offset) {
+    return;
+  }
+  // NOTE(josh): notes are aligned to four bytes, except in segments aligned to
+  // eight (e.g. `.note.gnu.property`) which are aligned to eight.
+  align = (align == 8) ? 8 : 4;
+  auto align_up = [align](uint64_t value) {
+    return (value + align - 1) & ~(align - 1);
+  };
+
+  const char* begin = image + offset;
+  uint64_t note_offset = 0;
+  while (note_offset < size && size - note_offset >= sizeof(Elf32_Nhdr)) {
+    Elf32_Nhdr nhdr;
+    std::memcpy(&nhdr, begin + note_offset, sizeof(nhdr));
+    uint64_t name_offset = note_offset + sizeof(nhdr);
+    uint64_t desc_offset = align_up(name_offset + nhdr.n_namesz);
+    if (desc_offset > size || nhdr.n_descsz > size - desc_offset) {
+      return;
+    }
+    const char* name = begin + name_offset;
+    const char* desc = begin + desc_offset;
+    note_offset = align_up(desc_offset + nhdr.n_descsz);
+
+    if (nhdr.n_namesz != sizeof(kElfNoteName) ||
+        std::memcmp(name, kElfNoteName, nhdr.n_namesz) != 0) {
+      continue;
+    }
+    notes->found = true;
+    switch (nhdr.n_type) {
+      case NOTE_CAPABILITY:
+        notes->spec_version.assign(desc, strnlen(desc, nhdr.n_descsz));
+        break;
+      case NOTE_COMPLETION_SPEC:
+        notes->completion_spec.assign(desc, strnlen(desc, nhdr.n_descsz));
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+bool find_argue_notes(const char* image, size_t image_size,
+                      ArgueNotes* notes) {
+  if (image_size < EI_NIDENT || std::memcmp(image, ELFMAG, SELFMAG) != 0) {
+    return false;
+  }
+  // NOTE(josh): the headers are read in place, so the notes can only be found
+  // in files of the same byte order as this program.
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (image[EI_DATA] != ELFDATA2LSB) {
+    return false;
+  }
+#else
+  if (image[EI_DATA] != ELFDATA2MSB) {
+    return false;
+  }
+#endif
+
+  switch (image[EI_CLASS]) {
+    case ELFCLASS32:
+      find_notes<Headers32>(image, image_size, notes);
+      return true;
+    case ELFCLASS64:
+      find_notes<Headers64>(image, image_size, notes);
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool has_supported_spec(const ArgueNotes& notes) {
+  if (notes.completion_spec.empty()) {
+    return false;
+  }
+  if (!notes.spec_version.empty() &&
+      notes.spec_version != kCompletionSpecVersion) {
+    return false;
+  }
+  std::string header = fmt::format("argue-completion-spec\t{}\n",
+                                   kCompletionSpecVersion);
+  return notes.completion_spec.compare(0, header.size(), header) == 0;
+}
+
+}  // namespace can_complete
+}  // namespace argue
@@ -0,0 +1,107 @@
+#pragma once
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "argue/util.h"
+
+namespace argue {
+
+// =============================================================================
+//                              Choice Set
+// =============================================================================
+
+// The set of values which an argument is allowed to take.
+/* The values are moved in when the set is constructed, and the set is
+ * immutable afterward so that a single set may be shared by any number of
+ * actions (e.g. several flags which all accept the same table of IDs).
+ *
+ * Membership is tested through an open addressing hash table of indices into
+ * the values, built once at construction. Types without a `std::hash`
+ * specialization all hash to the same slot, so for them `contains()` is a
+ * linear scan, as it always was.
+ *
+ * Completion matches the string form of each value (as written by
+ * `write_value`) against a prefix, using a sorted index of the string forms.
+ * That index is only built the first time it is needed, which is usually
+ * never outside of shell completion. */
+template <typename T>
+class ChoiceSet {
+ public:
+  explicit ChoiceSet(std::vector<T>&& values);
+  explicit ChoiceSet(const std::vector<T>& values);
+  ChoiceSet(const std::initializer_list<T>& values);
+
+  // Return true if `query` is equal to one of the values
+  bool contains(const T& query) const;
+
+  // Return true if there are no values in the set
+  bool empty() const;
+
+  // Return the number of values in the set
+  size_t size() const;
+
+  // Return the values in the order they were given
+  const std::vector<T>& values() const;
+
+  // Call `fn` with the string form of each value that starts with `prefix`,
+  // in lexicographical order. This is safe to call from multiple threads.
+  void for_each_completion(
+      const StringPiece& prefix,
+      const std::function<void(const StringPiece&)>& fn) const;
+
+ private:
+  ChoiceSet(const ChoiceSet&) = delete;
+  ChoiceSet& operator=(const ChoiceSet&) = delete;
+
+  // Build the hash table over `values_`
+  void build_table();
+
+  // Return the slot of the hash table at which to start probing for `value`
+  size_t get_slot(const T& value) const;
+
+  // Build the completion index, see `sorted_`
+  void build_sorted() const;
+
+  // Return the string form of the value at `idx`. Only valid once the
+  // completion index has been built.
+  StringPiece get_name(uint32_t idx) const;
+
+  std::vector<T> values_;  //< values, in the order they were given
+
+  // Open addressing hash table of indices into `values_`. The size is a power
+  // of two, and empty slots are `kEmptySlot`.
+  std::vector<uint32_t> table_;
+  int shift_;  //< 64 minus log2 of the size of `table_`
+
+  // Indices into `values_` sorted by the string form of the value, and those
+  // string forms (empty for `std::string` values, which are their own string
+  // form). Built by the first call to `for_each_completion`.
+  mutable std::once_flag sort_once_;
+  mutable std::vector<uint32_t> sorted_;
+  mutable std::vector<std::string> names_;
+
+  static const uint32_t kEmptySlot = 0xffffffff;
+};
+
+// Construct a choice set from `values`, which may be moved in. The result can
+// be passed as `choices=` to any number of arguments.
+template <typename T>
+std::shared_ptr<const ChoiceSet<T>> make_choices(std::vector<T>&& values);
+
+template <typename T>
+std::shared_ptr<const ChoiceSet<T>> make_choices(
+    const std::vector<T>& values);
+
+template <typename T>
+std::shared_ptr<const ChoiceSet<T>> make_choices(
+    const std::initializer_list<T>& values);
+
+}  // namespace argue
@@ -0,0 +1,191 @@
+#pragma once
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+
+#include <algorithm>
+#include <sstream>
+
+#include <fmt/format.h>
+
+#include "argue/choice_set.h"
+#include "argue/enum_table.h"
+#include "argue/exception.h"
+
+namespace argue {
+
+// Selected when there is a `std::hash` specialization for `T`
+template <typename T>
+auto hash_choice_impl(const T& value, int) -> decltype(std::hash<T>()(value)) {
+  return std::hash<T>()(value);
+}
+
+// Selected when `T` is not hashable. Every value lands in the same slot.
+template <typename T>
+size_t hash_choice_impl(const T& value, long) {
+  return 0;
+}
+
+// Fill `names` with the string form of each of `values`
+template <typename T>
+void render_choices(const std::vector<T>& values,
+                    std::vector<std::string>* names) {
+  names->reserve(values.size());
+  std::stringstream strm;
+  for (const T& value : values) {
+    strm.str("");
+    write_value(&strm, value);
+    names->emplace_back(strm.str());
+  }
+}
+
+// Strings are their own string form
+inline void render_choices(const std::vector<std::string>& values,
+                           std::vector<std::string>* names) {}
+
+template <typename T>
+StringPiece choice_name(const std::vector<T>& values,
+                        const std::vector<std::string>& names, uint32_t idx) {
+  return names[idx];
+}
+
+inline StringPiece choice_name(const std::vector<std::string>& values,
+                               const std::vector<std::string>& names,
+                               uint32_t idx) {
+  return values[idx];
+}
+
+template <typename T>
+const uint32_t ChoiceSet<T>::kEmptySlot;
+
+template <typename T>
+ChoiceSet<T>::ChoiceSet(std::vector<T>&& values) : values_(std::move(values)) {
+  build_table();
+}
+
+template <typename T>
+ChoiceSet<T>::ChoiceSet(const std::vector<T>& values) : values_(values) {
+  build_table();
+}
+
+template <typename T>
+ChoiceSet<T>::ChoiceSet(const std::initializer_list<T>& values)
+    : values_(values) {
+  build_table();
+}
+
+template <typename T>
+void ChoiceSet<T>::build_table() {
+  ARGUE_ASSERT(CONFIG_ERROR, values_.size() < kEmptySlot)
+      << fmt::format("Too many choices ({})", values_.size());
+
+  // NOTE(josh): the table is kept at most half full so that probe sequences
+  // are short, including for values which are not in the set.
+  size_t table_size = 16;
+  shift_ = 60;
+  while (table_size < 2 * values_.size()) {
+    table_size *= 2;
+    --shift_;
+  }
+  table_.assign(table_size, kEmptySlot);
+
+  size_t mask = table_size - 1;
+  for (uint32_t value_idx = 0; value_idx < values_.size(); ++value_idx) {
+    size_t idx = get_slot(values_[value_idx]);
+    for (; table_[idx] != kEmptySlot; idx = (idx + 1) & mask) {
+      if (values_[table_[idx]] == values_[value_idx]) {
+        break;
+      }
+    }
+    if (table_[idx] == kEmptySlot) {
+      table_[idx] = value_idx;
+    }
+  }
+}
+
+template <typename T>
+size_t ChoiceSet<T>::get_slot(const T& value) const {
+  // NOTE(josh): std::hash is the identity for integers on common
+  // implementations, so the hash is mixed (Fibonacci hashing) to keep runs of
+  // consecutive IDs from clustering in the table.
+  uint64_t hash = static_cast<uint64_t>(hash_choice_impl(value, 0));
+  return static_cast<size_t>((hash * 0x9e3779b97f4a7c15ull) >> shift_);
+}
+
+template <typename T>
+bool ChoiceSet<T>::contains(const T& query) const {
+  size_t mask = table_.size() - 1;
+  for (size_t idx = get_slot(query); table_[idx] != kEmptySlot;
+       idx = (idx + 1) & mask) {
+    if (values_[table_[idx]] == query) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+bool ChoiceSet<T>::empty() const {
+  return values_.empty();
+}
+
+template <typename T>
+size_t ChoiceSet<T>::size() const {
+  return values_.size();
+}
+
+template <typename T>
+const std::vector<T>& ChoiceSet<T>::values() const {
+  return values_;
+}
+
+template <typename T>
+StringPiece ChoiceSet<T>::get_name(uint32_t idx) const {
+  return choice_name(values_, names_, idx);
+}
+
+template <typename T>
+void ChoiceSet<T>::build_sorted() const {
+  render_choices(values_, &names_);
+  sorted_.resize(values_.size());
+  for (uint32_t idx = 0; idx < sorted_.size(); ++idx) {
+    sorted_[idx] = idx;
+  }
+  std::sort(sorted_.begin(), sorted_.end(), [this](uint32_t a, uint32_t b) {
+    return get_name(a) < get_name(b);
+  });
+  sorted_.erase(std::unique(sorted_.begin(), sorted_.end(),
+                            [this](uint32_t a, uint32_t b) {
+                              return get_name(a) == get_name(b);
+                            }),
+                sorted_.end());
+}
+
+template <typename T>
+void ChoiceSet<T>::for_each_completion(
+    const StringPiece& prefix,
+    const std::function<void(const StringPiece&)>& fn) const {
+  std::call_once(sort_once_, [this]() { this->build_sorted(); });
+  auto range = prefix_range(sorted_.begin(), sorted_.end(), prefix,
+                            [this](uint32_t idx) { return get_name(idx); });
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    fn(get_name(*iter));
+  }
+}
+
+template <typename T>
+std::shared_ptr<const ChoiceSet<T>> make_choices(std::vector<T>&& values) {
+  return std::make_shared<const ChoiceSet<T>>(std::move(values));
+}
+
+template <typename T>
+std::shared_ptr<const ChoiceSet<T>> make_choices(
+    const std::vector<T>& values) {
+  return std::make_shared<const ChoiceSet<T>>(values);
+}
+
+template <typename T>
+std::shared_ptr<const ChoiceSet<T>> make_choices(
+    const std::initializer_list<T>& values) {
+  return std::make_shared<const ChoiceSet<T>>(values);
+}
+
+}  // namespace argue
@@ -0,0 +1,66 @@
+#pragma once
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+//                              ELF Notes
+// =============================================================================
+
+// Notes are only emitted for ELF targets, where the compiler lets us place
+// data in a named section.
+#if defined(__ELF__) && defined(__GNUC__)
+#define ARGUE_HAVE_ELF_NOTES 1
+// Place a definition in the `.note.argue` section. The assembler gives
+// sections named `.note*` the type `SHT_NOTE`, and the linker covers them
+// with a `PT_NOTE` program header, so they survive `strip`.
+#define ARGUE_ELF_NOTE \
+  __attribute__((section(".note.argue"), used, aligned(4)))
+#else
+#define ARGUE_HAVE_ELF_NOTES 0
+#define ARGUE_ELF_NOTE
+#endif
+
+namespace argue {
+
+// Owner name of every argue note, including the terminating null
+static const char kElfNoteName[] = "argue";
+
+// Version of the completion spec format (see `Parser::write_completion_spec`),
+// written on its first line and in the descriptor of the capability note.
+static const char kCompletionSpecVersion[] = "1";
+
+// Types of the notes in the `.note.argue` section
+enum ElfNoteType {
+  // Marks the program as using argue, so that it can complete its own
+  // arguments. The descriptor is `kCompletionSpecVersion`, and
+  // `argue-can-complete --print-spec` only extracts an embedded spec from a
+  // program whose version matches its own.
+  /* The note is defined in parser.cc, so a program only carries it if it
+   * links the static library. When linked with `libargue.so` the note is in
+   * the library instead, and the program itself is only detected if it embeds
+   * its spec (see `argue_help_artifacts()`). */
+  NOTE_CAPABILITY = 1,
+
+  // The completion spec of the program (see
+  // `Parser::write_completion_spec`), null terminated. Generated at build time
+  // by `argue_help_artifacts()` so that static completions can be answered
+  // without executing the program.
+  NOTE_COMPLETION_SPEC = 2,
+};
+
+// Layout of an ELF note whose descriptor is a string of `N` bytes, including
+// the terminating null.
+/* The name and descriptor are each padded to a multiple of four bytes, as
+ * required of notes in both 32 and 64 bit ELF files. */
+template <size_t N>
+struct ElfNote {
+  uint32_t namesz;  //< size of the name, including the null
+  uint32_t descsz;  //< size of the descriptor
+  uint32_t type;    //< one of `ElfNoteType`
+  char name[(sizeof(kElfNoteName) + 3) / 4 * 4];
+  char desc[(N + 3) / 4 * 4];
+};
+
+}  // namespace argue
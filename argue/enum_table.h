@@ -0,0 +1,180 @@
+#pragma once
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argue/util.h"
+
+namespace argue {
+
+// =============================================================================
+//                              Enum Tables
+// =============================================================================
+
+// One enumerator of an enum table: the name used on the command line, and the
+// value it stands for.
+/* The length of the name is computed at compile time from the string
+ * literal, so matching a token against the table rejects most entries by
+ * length alone. */
+template <typename Enum>
+struct EnumEntry {
+  template <size_t N>
+  constexpr EnumEntry(const char (&name)[N], Enum value)
+      : name(name), size(N - 1), value(value) {}
+
+  const char* name;  //< the name, as accepted on the command line
+  size_t size;       //< length of `name`
+  Enum value;        //< the value it stands for
+};
+
+// A view of a static array of `EnumEntry`, see `EnumTraits`
+template <typename Enum>
+class EnumTable {
+ public:
+  template <size_t N>
+  constexpr EnumTable(  // NOLINT(runtime/explicit)
+      const EnumEntry<Enum> (&entries)[N])
+      : begin_(entries), end_(entries + N) {}
+
+  constexpr const EnumEntry<Enum>* begin() const {
+    return begin_;
+  }
+
+  constexpr const EnumEntry<Enum>* end() const {
+    return end_;
+  }
+
+  // Return the entry named `name` or nullptr if there is no such entry
+  const EnumEntry<Enum>* find_name(const StringPiece& name) const {
+    for (const EnumEntry<Enum>* entry = begin_; entry < end_; ++entry) {
+      if (entry->size == name.size() &&
+          std::memcmp(entry->name, name.data(), name.size()) == 0) {
+        return entry;
+      }
+    }
+    return nullptr;
+  }
+
+  // Return the first entry for `value` or nullptr if there is no such entry
+  const EnumEntry<Enum>* find_value(Enum value) const {
+    for (const EnumEntry<Enum>* entry = begin_; entry < end_; ++entry) {
+      if (entry->value == value) {
+        return entry;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  const EnumEntry<Enum>* begin_;
+  const EnumEntry<Enum>* end_;
+};
+
+// Specialize this template to use an enum as the type of an argument.
+/* The specialization provides a static `table()` which returns the names of
+ * the enumerators, e.g.:
+ *
+ *     enum class Color { RED, GREEN, BLUE };
+ *
+ *     namespace argue {
+ *     template <>
+ *     struct EnumTraits<Color> {
+ *       static EnumTable<Color> table() {
+ *         static constexpr EnumEntry<Color> kEntries[] = {
+ *             {"red", Color::RED},
+ *             {"green", Color::GREEN},
+ *             {"blue", Color::BLUE},
+ *         };
+ *         return kEntries;
+ *       }
+ *     };
+ *     }  // namespace argue
+ *
+ * Arguments of that type then parse the names directly into the enum, and
+ * help and completion list the names, all from the same static table. A value
+ * may have more than one name, in which case the first is used for output. */
+template <typename Enum>
+struct EnumTraits {};
+
+// Parse the name of an enumerator into `value`. Only participates for enums
+// with an `EnumTraits` table.
+template <typename Enum>
+auto parse(const StringPiece& str, Enum* value)
+    -> decltype(EnumTraits<Enum>::table(), int()) {
+  const EnumEntry<Enum>* entry = EnumTraits<Enum>::table().find_name(str);
+  if (!entry) {
+    return -1;
+  }
+  *value = entry->value;
+  return 0;
+}
+
+// Selected when `T` has an `EnumTraits` table
+template <typename T>
+auto write_value_impl(std::ostream* out, const T& value, int)
+    -> decltype(EnumTraits<T>::table(), void()) {
+  const EnumEntry<T>* entry = EnumTraits<T>::table().find_value(value);
+  if (entry) {
+    out->write(entry->name, entry->size);
+  } else {
+    (*out) << "<invalid>";
+  }
+}
+
+// Selected for all other types
+template <typename T>
+void write_value_impl(std::ostream* out, const T& value, long) {
+  (*out) << value;
+}
+
+// Write `value` to `out` as it would be written on the command line. This is
+// the name of the value for an enum with an `EnumTraits` table, otherwise it
+// is whatever `operator<<` writes.
+template <typename T>
+void write_value(std::ostream* out, const T& value) {
+  write_value_impl(out, value, 0);
+}
+
+// Return `values` written with `write_value` and joined by `separator`
+template <typename T>
+std::string join_values(const std::vector<T>& values,
+                        const char* separator = ", ") {
+  std::stringstream strm;
+  for (size_t idx = 0; idx < values.size(); ++idx) {
+    if (idx > 0) {
+      strm << separator;
+    }
+    write_value(&strm, values[idx]);
+  }
+  return strm.str();
+}
+
+// Selected when `T` has an `EnumTraits` table
+template <typename T, typename Fn>
+auto for_each_enum_name_impl(const StringPiece& prefix, const Fn& fn, int)
+    -> decltype(EnumTraits<T>::table(), void()) {
+  for (const EnumEntry<T>& entry : EnumTraits<T>::table()) {
+    StringPiece name(entry.name, entry.size);
+    if (name.starts_with(prefix)) {
+      fn(name);
+    }
+  }
+}
+
+// Selected for all other types, which have no names
+template <typename T, typename Fn>
+void for_each_enum_name_impl(const StringPiece& prefix, const Fn& fn, long) {}
+
+// Call `fn` with each name in the `EnumTraits` table of `T` which starts
+// with `prefix`, in table order. Does nothing if `T` has no table.
+template <typename T, typename Fn>
+void for_each_enum_name(const StringPiece& prefix, const Fn& fn) {
+  for_each_enum_name_impl<T>(prefix, fn, 0);
+}
+
+}  // namespace argue
@@ -23,29 +23,40 @@ int main(int argc, char** argv) {
   meta.name = "subparser-example";
   argue::Parser parser{meta};
 
-  ProgramOptions progopts{};
-  auto subparsers = parser.add_subparsers("command", &progopts.command);
+  // NOTE: destinations are members of ProgramOptions, the object to fill is
+  // supplied to parse_args() below.
+  using argue::member;
+  typedef ProgramOptions::Foo Foo;
+  typedef ProgramOptions::Bar Bar;
+  auto subparsers = parser.add_subparsers("command", &ProgramOptions::command);
 
   auto foo_parser =
       subparsers->add_parser("foo", {.help = "The foo command does foo"});
   {
-    auto spec = foo_parser->add_argument("arg1", &progopts.foo.arg1);
+    auto spec = foo_parser->add_argument(
+        "arg1", member(&ProgramOptions::foo, &Foo::arg1));
     spec.help = "First positional argument is mandatory";
   }
   {
-    auto spec = foo_parser->add_argument("arg2", &progopts.foo.arg2);
+    auto spec = foo_parser->add_argument(
+        "arg2", member(&ProgramOptions::foo, &Foo::arg2));
     spec.nargs = "?";
     spec.help = "Second positional argument is optional";
   }
-  foo_parser->add_argument("--foo-opt1", &progopts.foo.option1);
-  foo_parser->add_argument("--foo-opt2", &progopts.foo.option2);
+  foo_parser->add_argument("--foo-opt1",
+                           member(&ProgramOptions::foo, &Foo::option1));
+  foo_parser->add_argument("--foo-opt2",
+                           member(&ProgramOptions::foo, &Foo::option2));
 
   auto bar_parser =
       subparsers->add_parser("bar", {.help = "The bar command does bar"});
-  bar_parser->add_argument("--bar-opt1", &progopts.bar.option1);
-  bar_parser->add_argument("--bar-opt2", &progopts.bar.option2);
+  bar_parser->add_argument("--bar-opt1",
+                           member(&ProgramOptions::bar, &Bar::option1));
+  bar_parser->add_argument("--bar-opt2",
+                           member(&ProgramOptions::bar, &Bar::option2));
 
-  int parse_result = parser.parse_args(argc, argv);
+  ProgramOptions progopts{};
+  int parse_result = parser.parse_args(&progopts, argc, argv);
   switch (parse_result) {
     case argue::PARSE_ABORTED:
       return 0;
@@ -4,6 +4,11 @@
 #include <cxxabi.h>
 #include <execinfo.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+
 namespace argue {
 
 // =============================================================================
@@ -59,32 +64,44 @@ static void parse_traceline(char* symbol, TraceLine* traceline) {
   }
 }
 
-// TODO(josh): use libunwind
-StackTrace get_stacktrace(size_t skip_frames, size_t max_frames) {
-  StackTrace result;
-  std::vector<void*> addrlist(max_frames + 1);
+StackTrace::StackTrace() : symbolized_(false) {}
 
-  // http://man7.org/linux/man-pages/man3/backtrace.3.html
-  int addrlen = backtrace(&addrlist[0], addrlist.size());
-  if (addrlen == 0) {
-    return {{0, "<empty, possibly corrupt>"}};
+size_t StackTrace::size() const {
+  return addrs_.size();
+}
+
+bool StackTrace::empty() const {
+  return addrs_.empty();
+}
+
+void* StackTrace::address(size_t idx) const {
+  return addrs_[idx];
+}
+
+const TraceLine& StackTrace::operator[](size_t idx) const {
+  return get_lines()[idx];
+}
+
+const std::vector<TraceLine>& StackTrace::get_lines() const {
+  if (symbolized_ || addrs_.empty()) {
+    symbolized_ = true;
+    return lines_;
   }
 
   // symbol -> "filename(function+offset)" (this array needs to free())
-  char** symbols = backtrace_symbols(&addrlist[0], addrlen);
+  char** symbols = backtrace_symbols(&addrs_[0], addrs_.size());
 
   // We have to malloc this, can't use std::string(), because demangle function
   // may realloc() it.
   size_t funcnamesize = 256;
   char* funcnamebuf = static_cast<char*>(malloc(funcnamesize));
 
-  // Iterate over the returned symbol lines, skipping frames as requested,
-  // and one extra for this function.
-  result.reserve(addrlen - skip_frames);
-  for (size_t idx = skip_frames + 1; idx < static_cast<size_t>(addrlen);
-       idx++) {
-    TraceLine traceline{.addr = addrlist[idx]};
-    parse_traceline(symbols[idx], &traceline);
+  lines_.reserve(addrs_.size());
+  for (size_t idx = 0; idx < addrs_.size(); idx++) {
+    TraceLine traceline{.addr = addrs_[idx]};
+    if (symbols) {
+      parse_traceline(symbols[idx], &traceline);
+    }
     int status = 0;
     if (traceline.name.size()) {
       char* ret = abi::__cxa_demangle(traceline.name.c_str(), funcnamebuf,
@@ -94,12 +111,38 @@ StackTrace get_stacktrace(size_t skip_frames, size_t max_frames) {
         traceline.name = funcnamebuf;
       }
     }
-
-    result.push_back(traceline);
+    lines_.push_back(traceline);
   }
 
   free(funcnamebuf);
   free(symbols);
+  symbolized_ = true;
+  return lines_;
+}
+
+std::vector<TraceLine>::const_iterator StackTrace::begin() const {
+  return get_lines().begin();
+}
+
+std::vector<TraceLine>::const_iterator StackTrace::end() const {
+  return get_lines().end();
+}
+
+// NOTE(josh): backtrace() walks the stack with the same unwinder that the
+// exception runtime uses, and only records return addresses. It's the
+// symbolization step (backtrace_symbols + demangling) which is expensive, and
+// that is deferred to StackTrace::get_lines().
+StackTrace get_stacktrace(size_t skip_frames, size_t max_frames) {
+  StackTrace result;
+  // Skip frames as requested, and one extra for this function.
+  std::vector<void*>& addrs = result.addrs_;
+  addrs.resize(max_frames + skip_frames + 1);
+
+  // http://man7.org/linux/man-pages/man3/backtrace.3.html
+  int addrlen = backtrace(&addrs[0], addrs.size());
+  size_t skip = std::min<size_t>(skip_frames + 1, addrlen);
+  addrs.erase(addrs.begin(), addrs.begin() + skip);
+  addrs.resize(addrlen - skip);
   return result;
 }
 
@@ -121,27 +164,48 @@ const char* Exception::to_string(TypeNo typeno) {
 }
 
 // message will be appended
-Assertion::Assertion(Exception::TypeNo typeno, bool expr)
-    : typeno(typeno), expr_(expr) {}
+Assertion::Assertion(Exception::TypeNo typeno) : typeno(typeno) {}
 
 // construct with message
-Assertion::Assertion(Exception::TypeNo typeno, bool expr,
-                     const std::string& message)
-    : typeno(typeno), expr_(expr) {
-  if (!expr) {
-    sstream << message;
+Assertion::Assertion(Exception::TypeNo typeno, const char* message)
+    : typeno(typeno) {
+  sstream << message;
+}
+
+// Process-wide stack trace policy, see Exception::set_trace_policy
+static std::atomic<int> g_trace_policy{Exception::TRACE_BUGS};
+
+void Exception::set_trace_policy(TracePolicy policy) {
+  g_trace_policy.store(policy, std::memory_order_relaxed);
+}
+
+bool Exception::should_trace(TypeNo typeno) {
+  switch (g_trace_policy.load(std::memory_order_relaxed)) {
+    case TRACE_ALL:
+      return true;
+    case TRACE_NONE:
+      return false;
+    default:
+      return typeno == BUG;
   }
 }
 
 void operator&&(const argue::AssertionSentinel& sentinel,
                 const argue::Assertion& assertion) {
-  if (!assertion.expr_) {
-    argue::Exception ex{assertion.typeno, assertion.sstream.str()};
-    ex.file = sentinel.file;
-    ex.lineno = sentinel.lineno;
+  argue::Exception ex{assertion.typeno, assertion.sstream.str()};
+  ex.file = sentinel.file;
+  ex.lineno = sentinel.lineno;
+  if (Exception::should_trace(assertion.typeno)) {
     ex.stack_trace = get_stacktrace();
-    throw ex;
   }
+#if ARGUE_EXCEPTIONS
+  throw ex;
+#else
+  std::cerr << sentinel.file << ":" << sentinel.lineno << " "
+            << Exception::to_string(ex.typeno) << ": " << ex.message << "\n"
+            << ex.stack_trace;
+  std::abort();
+#endif
 }
 
 std::ostream& operator<<(std::ostream& out, const StackTrace& trace) {
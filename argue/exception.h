@@ -21,11 +21,49 @@ struct TraceLine {
   std::string saddr;   //< string representation of the symbol address
 };
 
-// A stack trace is just a vector of stack line information
-typedef std::vector<TraceLine> StackTrace;
+// The call stack at the point an exception was thrown
+/* Capturing a stack trace only records the raw return addresses of each
+ * frame, which is cheap. Resolving those addresses to symbol names and
+ * demangling them is expensive, so it is deferred until the trace is
+ * inspected or printed, and the result is cached.
+ *
+ * NOTE(josh): the cache is not synchronized. A trace should not be inspected
+ * from multiple threads at once, which is fine for exceptions. */
+class StackTrace {
+ public:
+  StackTrace();
+
+  // Return the number of frames in the trace
+  size_t size() const;
+
+  // Return true if no frames were captured
+  bool empty() const;
+
+  // Return the raw return address of the frame at `idx`
+  void* address(size_t idx) const;
+
+  // Return symbol information for the frame at `idx`, symbolizing the trace
+  // if it hasn't been already.
+  const TraceLine& operator[](size_t idx) const;
+
+  // Return symbol information for all frames, symbolizing the trace if it
+  // hasn't been already.
+  const std::vector<TraceLine>& get_lines() const;
 
-// Return the current stack trace. ``skip_frames`` defaults to 2 because
-// the argue::Assertion adds two calls to the stack.
+  std::vector<TraceLine>::const_iterator begin() const;
+  std::vector<TraceLine>::const_iterator end() const;
+
+ private:
+  friend StackTrace get_stacktrace(size_t skip_frames, size_t max_frames);
+
+  std::vector<void*> addrs_;              //< raw frame addresses
+  mutable bool symbolized_;               //< true if `lines_` is populated
+  mutable std::vector<TraceLine> lines_;  //< symbol information per frame
+};
+
+// Return the current stack trace. ``skip_frames`` defaults to 1 to skip
+// the frame of the function which throws argue exceptions. Only the frame
+// addresses are recorded, see `StackTrace`.
 StackTrace get_stacktrace(size_t skip_frames = 1, size_t max_frames = 50);
 
 // Print the stack trace line by line to the output stream.
@@ -43,25 +81,123 @@ class Exception : public std::exception {
     INPUT_ERROR,   // Program user error
   };
 
+  // Which exceptions record a stack trace when they are thrown
+  enum TracePolicy {
+    TRACE_BUGS = 0,  // Only BUG exceptions (the default)
+    TRACE_ALL,       // All exceptions
+    TRACE_NONE,      // No exceptions
+  };
+
   Exception(TypeNo typeno, const std::string& message)
-      : typeno(typeno), message(message) {}
+      : typeno(typeno), lineno(0), message(message) {}
   const char* what() const noexcept override;
   static const char* to_string(TypeNo typeno);
 
+  // Set the process-wide policy for which exceptions capture a stack trace.
+  // Exceptions due to user input are routine, and so by default they do not
+  // pay for capturing one.
+  static void set_trace_policy(TracePolicy policy);
+
+  // Return true if an exception of type `typeno` should capture a stack
+  // trace under the current policy.
+  static bool should_trace(TypeNo typeno);
+
   TypeNo typeno;
   std::string file;
   int lineno;
   std::string message;
-  StackTrace stack_trace;
+  StackTrace stack_trace;  //< empty unless captured according to the policy
 };
 
+// True if the library is compiled with exception support. When it is not
+// (e.g. `-fno-exceptions`), a failed assertion prints the error and aborts
+// instead of throwing. Input errors can still be handled without aborting by
+// parsing with `Parser::try_parse_args`.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define ARGUE_EXCEPTIONS 1
+#else
+#define ARGUE_EXCEPTIONS 0
+#endif
+
+// Branch prediction hints for the assertion macros
+#if defined(__GNUC__) || defined(__clang__)
+#define ARGUE_PREDICT_TRUE(x) (__builtin_expect(static_cast<bool>(x), 1))
+#define ARGUE_PREDICT_FALSE(x) (__builtin_expect(static_cast<bool>(x), 0))
+#define ARGUE_COLD __attribute__((cold, noinline))
+#else
+#define ARGUE_PREDICT_TRUE(x) (x)
+#define ARGUE_PREDICT_FALSE(x) (x)
+#define ARGUE_COLD
+#endif
+
+// The outcome of evaluating the condition of an assertion
+/* This is the only object constructed when an assertion passes. It holds the
+ * result of the condition and, for the three-argument form of
+ * `ARGUE_ASSERT`, a pointer to the message literal. No stream or string is
+ * constructed unless the assertion fails. */
+struct AssertionCheck {
+  explicit AssertionCheck(bool passed, const char* message = "")
+      : passed(passed), message(message) {}
+
+  // NOTE(josh): the hint lives here, rather than in the macro, because the
+  // macro evaluates this object as the condition of an if-statement.
+  explicit operator bool() const {
+    return ARGUE_PREDICT_TRUE(passed);
+  }
+
+  bool passed;          //< the value of the asserted expression
+  const char* message;  //< the message, if one was given with the assertion
+};
+
+// Same as `AssertionCheck` but for a message which is not a literal. The
+// message is only copied if the assertion fails.
+struct OwningAssertionCheck {
+  OwningAssertionCheck(bool passed, const std::string& message)
+      : passed(passed) {
+    if (ARGUE_PREDICT_FALSE(!passed)) {
+      this->message = message;
+    }
+  }
+
+  explicit operator bool() const {
+    return ARGUE_PREDICT_TRUE(passed);
+  }
+
+  bool passed;
+  std::string message;
+};
+
+// Evaluate the arguments of `ARGUE_ASSERT`
+inline AssertionCheck check_assertion(bool expr) {
+  return AssertionCheck{expr};
+}
+
+inline AssertionCheck check_assertion(bool expr, const char* message) {
+  return AssertionCheck{expr, message};
+}
+
+inline OwningAssertionCheck check_assertion(bool expr,
+                                            const std::string& message) {
+  return OwningAssertionCheck{expr, message};
+}
+
+// Return the message given with the assertion
+inline const char* get_message(const AssertionCheck& check) {
+  return check.message;
+}
+
+inline const char* get_message(const OwningAssertionCheck& check) {
+  return check.message.c_str();
+}
+
 // Stores the file name and line number of an assertion exception.
 /* An assetion sentinel captures the current file and line number so that the
  * correct value is used, even if the message occurs at a later line. It also
  * serves as an indicator to the compiler which overload of operator&&() to
- * use during assertions. */
+ * use during assertions. The file name is always a string literal so it is
+ * stored by pointer. */
 struct AssertionSentinel {
-  std::string file;
+  const char* file;
   int lineno;
 };
 
@@ -70,23 +206,23 @@ struct AssertionSentinel {
  * be conveniently composed. The purpose of an Assertion object is just to
  * hold the exception type and message used to construct an exception. The
  * exception itself is not constructructed and thrown until the
- * `operator&&` is called */
+ * `operator&&` is called.
+ *
+ * An Assertion is only ever constructed once an assertion has already failed,
+ * so the arguments to the stream operators are never evaluated when the
+ * assertion passes. */
 class Assertion {
  public:
   // message will be appended
-  explicit Assertion(Exception::TypeNo typeno, bool expr);
+  explicit Assertion(Exception::TypeNo typeno);
 
   // construct with message
-  Assertion(Exception::TypeNo typeno, bool expr, const std::string& message);
+  Assertion(Exception::TypeNo typeno, const char* message);
 
   template <typename T>
   Assertion& operator<<(const T& x);
 
-  template <typename T>
-  Assertion& operator<<(const T&& x);
-
   Exception::TypeNo typeno;   //< The exception type number
-  bool expr_;                 //< The boolean expression being evaluated
   std::stringstream sstream;  //< stringstream to store the intermediate message
                               // as it's being constructed
 };
@@ -102,8 +238,9 @@ class Assertion {
  * AssertionSentinel(...) && Assertion(...) << "Message";
  * ```
  */
-void operator&&(const argue::AssertionSentinel& sentinel,
-                const argue::Assertion& assertion);
+[[noreturn]] ARGUE_COLD void operator&&(
+    const argue::AssertionSentinel& sentinel,
+    const argue::Assertion& assertion);
 
 }  // namespace argue
 
@@ -118,10 +255,22 @@ void operator&&(const argue::AssertionSentinel& sentinel,
  * ARGUE_ASSERT(INPUT_ERROR, a == b)
  *  << "Message line 1\n"
  *  << "Message line 2\n";
- * ``` */
-#define ARGUE_ASSERT(typeno, ...)                     \
-  ::argue::AssertionSentinel({__FILE__, __LINE__}) && \
-      ::argue::Assertion(::argue::Exception::typeno, __VA_ARGS__)
+ * ```
+ *
+ * The expression is evaluated exactly once. Everything streamed into the
+ * assertion is only evaluated if the expression is false, so it is fine to
+ * stream expensive messages. An optional third argument is accepted as the
+ * start of the message, but since it is an ordinary function argument it is
+ * always evaluated; prefer a string literal there.
+ *
+ * The expansion is a complete if/else statement, so it composes correctly with
+ * an enclosing if/else that doesn't use braces. */
+#define ARGUE_ASSERT(typeno, ...)                                             \
+  if (auto _argue_check = ::argue::check_assertion(__VA_ARGS__)) {            \
+  } else /* NOLINT */                                                         \
+    ::argue::AssertionSentinel{__FILE__, __LINE__} &&                         \
+        ::argue::Assertion(::argue::Exception::typeno,                        \
+                           ::argue::get_message(_argue_check))
 
 // Throw an exception using the exception message builder
 /* Use this macro as if it was a function with following signatures:
@@ -137,9 +286,9 @@ void operator&&(const argue::AssertionSentinel& sentinel,
  *  << "Message line 1\n"
  *  << "Message line 2\n";
  * ``` */
-#define ARGUE_THROW(typeno)                           \
-  ::argue::AssertionSentinel({__FILE__, __LINE__}) && \
-      ::argue::Assertion(::argue::Exception::typeno, false)
+#define ARGUE_THROW(typeno)                        \
+  ::argue::AssertionSentinel{__FILE__, __LINE__} && \
+      ::argue::Assertion(::argue::Exception::typeno)
 
 //
 //
@@ -153,17 +302,7 @@ namespace argue {
 
 template <typename T>
 Assertion& Assertion::operator<<(const T& x) {
-  if (!expr_) {
-    sstream << x;
-  }
-  return *this;
-}
-
-template <typename T>
-Assertion& Assertion::operator<<(const T&& x) {
-  if (!expr_) {
-    sstream << x;
-  }
+  sstream << x;
   return *this;
 }
 
@@ -0,0 +1,101 @@
+# NOTE(josh): functions do not capture the variables of the listfile which
+# defines them, so the location of the script is stored globally.
+set_property(GLOBAL PROPERTY ARGUE_HELP_ARTIFACTS_SCRIPT
+                             ${CMAKE_CURRENT_LIST_DIR}/help_artifacts.py)
+
+# Pre-generate the help of an argue program at build time. Usage:
+# ~~~
+#   argue_help_artifacts(<target>
+#     [OUTPUT_DIRECTORY <dir>]
+#     [MAN_SECTION <section>]
+#     [ALL]
+#     [INSTALL])
+# ~~~
+#
+# Adds a target `<target>.help` which runs `<target>` once, with
+# `ARGUE_HELP_FORMAT=export`, to extract the help of its whole command tree.
+# From that one extraction it writes, for every (sub)command:
+#
+# * `<command>.txt`: the text printed by `--help`
+# * `<command>.md`: a markdown page
+# * `<command>.<section>`: a man page
+#
+# where `<command>` is the command path joined by dashes (e.g. `prog-sub`),
+# as well as `<prog>.json`, the exported tree. The program must have been
+# constructed with `add_help`.
+#
+# It also writes `<target>-help.cc`, which registers the text help with
+# `argue::register_help_text()` and embeds the completion spec in the
+# `.note.argue` section, and assigns its path to `<target>_HELP_SOURCE` in the
+# calling scope. Add that source to a binary built from the same parser
+# definition so that `--help` prints the precomputed text, and so that shell
+# completion can read the spec without executing the binary. It cannot be
+# compiled into `<target>` itself, which produces it.
+#
+# Keyword Arguments:
+#
+# *OUTPUT_DIRECTORY*: where to write the artifacts, the default is
+# `${CMAKE_CURRENT_BINARY_DIR}/<target>.help`
+#
+# *MAN_SECTION*: section of the man pages, the default is 1
+#
+# *ALL*: build the artifacts with the default target
+#
+# *INSTALL*: install the man pages to `${CMAKE_INSTALL_MANDIR}/man<section>`
+# and the text, markdown and JSON to `${CMAKE_INSTALL_DOCDIR}/<target>`
+function(argue_help_artifacts target_name)
+  set(_flags ALL INSTALL)
+  set(_oneargs OUTPUT_DIRECTORY MAN_SECTION)
+  set(_multiargs)
+  cmake_parse_arguments(_args "${_flags}" "${_oneargs}" "${_multiargs}" ${ARGN})
+
+  if(NOT _args_OUTPUT_DIRECTORY)
+    set(_args_OUTPUT_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/${target_name}.help)
+  endif()
+  if(NOT _args_MAN_SECTION)
+    set(_args_MAN_SECTION 1)
+  endif()
+
+  get_property(_script GLOBAL PROPERTY ARGUE_HELP_ARTIFACTS_SCRIPT)
+  set(_source ${_args_OUTPUT_DIRECTORY}/${target_name}-help.cc)
+  set(_stamp ${_args_OUTPUT_DIRECTORY}/${target_name}.stamp)
+
+  add_custom_command(
+    OUTPUT ${_stamp} ${_source}
+    COMMAND
+      # cmake-format: off
+      python -B ${_script}
+        --exe-path $<TARGET_FILE:${target_name}>
+        --outdir ${_args_OUTPUT_DIRECTORY}
+        --man-section ${_args_MAN_SECTION}
+        --embed-source ${_source}
+        --stamp ${_stamp}
+      # cmake-format: on
+    DEPENDS ${target_name} ${_script}
+    COMMENT "Extracting help artifacts from ${target_name}")
+
+  set(_all)
+  if(_args_ALL)
+    set(_all ALL)
+  endif()
+  add_custom_target(${target_name}.help ${_all} DEPENDS ${_stamp})
+
+  if(_args_INSTALL)
+    install(
+      DIRECTORY ${_args_OUTPUT_DIRECTORY}/
+      DESTINATION "${CMAKE_INSTALL_MANDIR}/man${_args_MAN_SECTION}"
+      FILES_MATCHING
+      PATTERN "*.${_args_MAN_SECTION}")
+    install(
+      DIRECTORY ${_args_OUTPUT_DIRECTORY}/
+      DESTINATION "${CMAKE_INSTALL_DOCDIR}/${target_name}"
+      FILES_MATCHING
+      PATTERN "*.txt"
+      PATTERN "*.md"
+      PATTERN "*.json")
+  endif()
+
+  set(${target_name}_HELP_SOURCE
+      ${_source}
+      PARENT_SCOPE)
+endfunction()
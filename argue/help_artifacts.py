@@ -0,0 +1,313 @@
+#!/usr/bin/env python
+"""
+Execute an argue program once to export the help of its whole command tree,
+and write the help of every (sub)command as text, markdown and man pages. The
+source written for `--embed-source` also embeds the completion spec. See
+`argue_help_artifacts()` in help_artifacts.cmake.
+"""
+
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import io
+import json
+import os
+import subprocess
+import sys
+
+
+def export_tree(exe_path):
+  """
+  Run the program with `ARGUE_HELP_FORMAT=export` and return the list of
+  parser objects it dumps.
+  """
+  env = dict(os.environ)
+  env["ARGUE_HELP_FORMAT"] = "export"
+  for key in ("ARGUE_HELP_RECURSE", "_ARGUECOMPLETE"):
+    env.pop(key, None)
+
+  proc = subprocess.Popen([exe_path, "--help"], env=env,
+                          stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+  stdout, stderr = proc.communicate()
+
+  # NOTE(josh): help is written to the log stream of the parse, which is
+  # stderr unless the program says otherwise.
+  for output in (stdout, stderr):
+    text = output.decode("utf-8").strip()
+    if text.startswith("["):
+      return json.loads(text)
+
+  raise RuntimeError(
+      "{} --help did not export its help (is add_help enabled?):\n{}"
+      .format(exe_path, stderr.decode("utf-8")))
+
+
+def export_completion_spec(exe_path):
+  """
+  Run the program with `_ARGUECOMPLETE=spec` and return the completion spec
+  of its command tree, or None if it does not write one.
+  """
+  env = dict(os.environ)
+  env["_ARGUECOMPLETE"] = "spec"
+
+  # NOTE(josh): --help is a safeguard for programs built against an argue
+  # which predates the spec, and so would otherwise run for real.
+  proc = subprocess.Popen([exe_path, "--help"], env=env,
+                          stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+  stdout, _ = proc.communicate()
+  spec = stdout.decode("utf-8")
+  if not spec.startswith("argue-completion-spec\t"):
+    return None
+  return spec
+
+
+def get_command(parser):
+  """
+  Return the command path of a parser, e.g. "prog sub".
+  """
+  meta = parser["metadata"]
+  return "{} {}".format(meta["comamnd_prefix"], meta["name"]).strip()
+
+
+def get_stem(command):
+  """
+  Return the file name stem for the artifacts of `command`.
+  """
+  return command.replace(" ", "-")
+
+
+def escape_roff(text):
+  """
+  Escape `text` for use in the body of a man page.
+  """
+  text = text.replace("\\", "\\e").replace("-", "\\-")
+  lines = []
+  for line in text.split("\n"):
+    if line.startswith(".") or line.startswith("'"):
+      line = "\\&" + line
+    lines.append(line)
+  return "\n".join(lines)
+
+
+def format_man(parser, root, section):
+  """
+  Return the man page for a parser.
+  """
+  meta = parser["metadata"]
+  command = get_command(parser)
+  summary = meta["prolog"].strip().split("\n")[0]
+
+  out = io.StringIO()
+  source = "{} {}".format(root["name"], root["version"]).strip()
+  out.write('.TH "{}" "{}" "" "{}" "{}"\n'.format(
+      escape_roff(get_stem(command).upper()), section, escape_roff(source),
+      escape_roff(root["name"])))
+  out.write(".SH NAME\n")
+  out.write(escape_roff(get_stem(command)))
+  if summary:
+    out.write(" \\- " + escape_roff(summary))
+  out.write("\n.SH SYNOPSIS\n.nf\n")
+  out.write(escape_roff(meta["usage"].strip()))
+  out.write("\n.fi\n")
+  if meta["prolog"]:
+    out.write(".SH DESCRIPTION\n")
+    out.write(escape_roff(meta["prolog"].strip()))
+    out.write("\n")
+
+  sections = (("OPTIONS", parser["flags"]),
+              ("ARGUMENTS", parser["positional"]),
+              ("COMMANDS", parser["subcommands"]))
+  for title, entries in sections:
+    if not entries:
+      continue
+    out.write(".SH {}\n".format(title))
+    for entry in entries:
+      if "name" in entry:
+        names = [entry["name"]]
+      else:
+        names = [flag for flag in (entry["short_flag"], entry["long_flag"])
+                 if flag]
+      out.write(".TP\n")
+      out.write(", ".join("\\fB{}\\fR".format(escape_roff(name))
+                          for name in names))
+      out.write("\n")
+      out.write(escape_roff(entry["help"].strip() or "-"))
+      out.write("\n")
+
+  if meta["epilog"]:
+    out.write(".SH NOTES\n")
+    out.write(escape_roff(meta["epilog"].strip()))
+    out.write("\n")
+  if root["author"]:
+    out.write(".SH AUTHOR\n")
+    out.write(escape_roff(root["author"]))
+    out.write("\n")
+  if root["copyright"]:
+    out.write(".SH COPYRIGHT\n")
+    out.write(escape_roff(root["copyright"]))
+    out.write("\n")
+  return out.getvalue()
+
+
+def format_markdown(parser, parsers_by_id):
+  """
+  Return the markdown page for a parser.
+  """
+  meta = parser["metadata"]
+  out = io.StringIO()
+  out.write("# {}\n\n".format(get_command(parser)))
+  if meta["prolog"]:
+    out.write(meta["prolog"].strip() + "\n\n")
+  out.write("```\n{}\n```\n".format(meta["usage"].strip()))
+
+  sections = (("Flags", parser["flags"]),
+              ("Positionals", parser["positional"]))
+  for title, entries in sections:
+    if not entries:
+      continue
+    out.write("\n## {}\n\n".format(title))
+    for entry in entries:
+      if "name" in entry:
+        names = [entry["name"]]
+      else:
+        names = [flag for flag in (entry["short_flag"], entry["long_flag"])
+                 if flag]
+      out.write("* {}".format(", ".join("`{}`".format(name)
+                                         for name in names)))
+      if entry["help"].strip():
+        out.write(": " + " ".join(entry["help"].split()))
+      out.write("\n")
+
+  if parser["subcommands"]:
+    out.write("\n## Subcommands\n\n")
+    for entry in parser["subcommands"]:
+      subparser = parsers_by_id.get(entry.get("id"))
+      if subparser is None:
+        out.write("* `{}`".format(entry["name"]))
+      else:
+        out.write("* [`{}`]({}.md)".format(
+            entry["name"], get_stem(get_command(subparser))))
+      if entry["help"].strip():
+        out.write(": " + " ".join(entry["help"].split()))
+      out.write("\n")
+
+  if meta["epilog"]:
+    out.write("\n" + meta["epilog"].strip() + "\n")
+  return out.getvalue()
+
+
+def escape_cxx(text):
+  """
+  Return `text` as the body of a C++ string literal.
+  """
+  out = []
+  for byte in bytearray(text.encode("utf-8")):
+    char = chr(byte)
+    if char == "\\":
+      out.append("\\\\")
+    elif char == "\"":
+      out.append("\\\"")
+    elif char == "\n":
+      out.append("\\n")
+    elif 0x20 <= byte < 0x7f and char != "?":
+      out.append(char)
+    else:
+      # NOTE(josh): three digit octal escapes cannot run into the next
+      # character, and escaping `?` avoids trigraphs.
+      out.append("\\{:03o}".format(byte))
+  return "".join(out)
+
+
+def format_cxx_literals(text, indent):
+  """
+  Return `text` as a sequence of C++ string literals, one per line.
+  """
+  literals = ['"{}"'.format(escape_cxx(line))
+              for line in text.splitlines(True)] or ['""']
+  return "\n".join(indent + literal for literal in literals)
+
+
+def format_embed_source(parsers, root, spec=None):
+  """
+  Return a C++ source which registers the text help of each parser with
+  `argue::register_help_text()`. If `spec` is given, the source also embeds
+  it as the completion spec note of the program (see argue/elf_note.h).
+  """
+  out = io.StringIO()
+  out.write("// Generated by argue/help_artifacts.py from the help of `{}`.\n"
+            "// Do not edit.\n".format(root["name"]))
+  out.write('#include "argue/elf_note.h"\n')
+  out.write('#include "argue/parser.h"\n\n')
+  out.write("namespace {\n\n")
+  out.write("const argue::PrecomputedHelp kHelpText[] = {\n")
+  for parser in parsers:
+    text = parser["help_text"]
+    out.write('    {{"{}",\n'.format(escape_cxx(get_command(parser))))
+    out.write(format_cxx_literals(text, "     "))
+    out.write(",\n")
+    out.write("     {}}},\n".format(len(text.encode("utf-8"))))
+  out.write("};\n\n")
+  out.write("const bool kRegistered = argue::register_help_text(\n"
+            "    kHelpText, kHelpText + sizeof(kHelpText) / "
+            "sizeof(kHelpText[0]));\n\n")
+  if spec is not None:
+    # NOTE(josh): the descriptor includes the terminating null
+    size = len(spec.encode("utf-8")) + 1
+    out.write("#if ARGUE_HAVE_ELF_NOTES\n")
+    out.write("ARGUE_ELF_NOTE const argue::ElfNote<{0}> kCompletionSpec = {{\n"
+              "    sizeof(argue::kElfNoteName), {0}, "
+              "argue::NOTE_COMPLETION_SPEC, \"argue\",\n".format(size))
+    out.write(format_cxx_literals(spec, "    "))
+    out.write("};\n#endif\n\n")
+  out.write("}  // namespace\n")
+  return out.getvalue()
+
+
+def write_file(path, content):
+  with io.open(path, "w", encoding="utf-8") as outfile:
+    outfile.write(content)
+
+
+def main():
+  argparser = argparse.ArgumentParser(description=__doc__)
+  argparser.add_argument("--exe-path", required=True,
+                         help="path to the argue program")
+  argparser.add_argument("--outdir", required=True,
+                         help="directory in which to write the artifacts")
+  argparser.add_argument("--man-section", default="1",
+                         help="section of the man pages")
+  argparser.add_argument("--embed-source",
+                         help="write a C++ source which embeds the text help "
+                         "and the completion spec")
+  argparser.add_argument("--stamp",
+                         help="touch this file when all artifacts are written")
+  args = argparser.parse_args()
+
+  parsers = export_tree(args.exe_path)
+  root = parsers[0]["metadata"]
+  parsers_by_id = dict((parser["metadata"]["id"], parser)
+                       for parser in parsers)
+
+  if not os.path.isdir(args.outdir):
+    os.makedirs(args.outdir)
+
+  write_file(os.path.join(args.outdir, get_stem(root["name"]) + ".json"),
+             json.dumps(parsers, indent=2, sort_keys=True) + "\n")
+  for parser in parsers:
+    stem = os.path.join(args.outdir, get_stem(get_command(parser)))
+    write_file(stem + ".txt", parser["help_text"])
+    write_file(stem + ".md", format_markdown(parser, parsers_by_id))
+    write_file("{}.{}".format(stem, args.man_section),
+               format_man(parser, root, args.man_section))
+
+  if args.embed_source:
+    spec = export_completion_spec(args.exe_path)
+    write_file(args.embed_source, format_embed_source(parsers, root, spec))
+  if args.stamp:
+    write_file(args.stamp, "")
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())
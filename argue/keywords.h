@@ -5,6 +5,7 @@
 #include <memory>
 
 #include "argue/action.h"
+#include "argue/choice_set.h"
 #include "argue/exception.h"
 #include "argue/parse.h"
 #include "argue/util.h"
@@ -38,7 +39,7 @@ template <TagNo TAG>
 struct Keyword {
   template <class T>
   KeywordArgument<TAG, T> operator=(T value) const {
-    return KeywordArgument<TAG, T>{value};
+    return KeywordArgument<TAG, T>{std::move(value)};
   }
 
   template <class T>
@@ -48,6 +49,30 @@ struct Keyword {
   }
 };
 
+// The "choices" keyword builds the choice set as soon as it is assigned, so
+// that the values are moved (or copied) exactly once and only a pointer is
+// passed along to the action.
+template <>
+struct Keyword<TAG_CHOICES> {
+  template <class T>
+  KeywordArgument<TAG_CHOICES, std::shared_ptr<const ChoiceSet<T>>> operator=(
+      std::vector<T> value) const {
+    return {make_choices(std::move(value))};
+  }
+
+  template <class T>
+  KeywordArgument<TAG_CHOICES, std::shared_ptr<const ChoiceSet<T>>> operator=(
+      const std::initializer_list<T>& value) const {
+    return {make_choices(value)};
+  }
+
+  template <class T>
+  KeywordArgument<TAG_CHOICES, std::shared_ptr<const ChoiceSet<T>>> operator=(
+      const std::shared_ptr<const ChoiceSet<T>>& value) const {
+    return {value};
+  }
+};
+
 // A keyword context is passed through the accumulation process
 template <class T>
 struct KeywordContext {
@@ -99,16 +124,13 @@ struct AssignmentHelper<TAG_DEFAULT> {
   static void assign(KeywordContext<T>* ctx, const T& value);
 };
 
-// Specialization for the "choices" keyword. Sets the list of choices
+// Specialization for the "choices" keyword. Sets the set of choices
 // for the action
 template <>
 struct AssignmentHelper<TAG_CHOICES> {
   template <class T>
   static void assign(KeywordContext<T>* ctx,
-                     const std::initializer_list<T>& choices);
-
-  template <class T>
-  static void assign(KeywordContext<T>* ctx, const std::vector<T>& choices);
+                     const std::shared_ptr<const ChoiceSet<T>>& choices);
 };
 
 // Specialization for the "dest" keyword. Sets the destination object
@@ -125,6 +147,17 @@ struct AssignmentHelper<TAG_DEST> {
   template <class T, class Allocator>
   static void assign(KeywordContext<T>* ctx,
                      std::list<T, Allocator>* destination);
+
+  template <class T, class Class, class Field>
+  static void assign(KeywordContext<T>* ctx, Field Class::*destination);
+
+  template <class T, class Class, class Field>
+  static void assign(KeywordContext<T>* ctx,
+                     const MemberPath<Class, Field>& destination);
+
+  template <class T>
+  static void assign(KeywordContext<T>* ctx,
+                     const std::shared_ptr<StorageModel<T>>& destination);
 };
 
 // Specialization for the "required" keyword. Sets the required flag on
@@ -252,6 +285,77 @@ struct MakeHelper<KeywordArgument<TAG_DEST, T*>> {
   }
 };
 
+// Specialization for a storage model destination keyword argument (e.g. from
+// `each<T>()`). As above, the element type of the model is the primitive
+// type of the action.
+template <class T, class... Args>
+struct MakeHelper<KeywordArgument<TAG_DEST, std::shared_ptr<StorageModel<T>>>,
+                  Args...> {
+  typedef T ElementType;
+  typedef KeywordContext<ElementType> ContextType;
+
+  static ContextType make_context() {
+    return {std::make_shared<StoreValue<ElementType>>()};
+  }
+};
+
+template <class T>
+struct MakeHelper<
+    KeywordArgument<TAG_DEST, std::shared_ptr<StorageModel<T>>>> {
+  typedef T ElementType;
+  typedef KeywordContext<ElementType> ContextType;
+
+  static ContextType make_context() {
+    return {std::make_shared<StoreValue<ElementType>>()};
+  }
+};
+
+// Specialization for a member destination keyword argument. As above, the
+// primitive type of the action is the element type of the member.
+template <class Class, class Field, class... Args>
+struct MakeHelper<KeywordArgument<TAG_DEST, Field Class::*>, Args...> {
+  typedef typename ElementType<Field>::value ElementType;
+  typedef KeywordContext<ElementType> ContextType;
+
+  static ContextType make_context() {
+    return {std::make_shared<StoreValue<ElementType>>()};
+  }
+};
+
+// Specialization for a member destination keyword argument, as above.
+template <class Class, class Field>
+struct MakeHelper<KeywordArgument<TAG_DEST, Field Class::*>> {
+  typedef typename ElementType<Field>::value ElementType;
+  typedef KeywordContext<ElementType> ContextType;
+
+  static ContextType make_context() {
+    return {std::make_shared<StoreValue<ElementType>>()};
+  }
+};
+
+// Specialization for a nested member destination keyword argument, as above.
+template <class Class, class Field, class... Args>
+struct MakeHelper<KeywordArgument<TAG_DEST, MemberPath<Class, Field>>,
+                  Args...> {
+  typedef typename ElementType<Field>::value ElementType;
+  typedef KeywordContext<ElementType> ContextType;
+
+  static ContextType make_context() {
+    return {std::make_shared<StoreValue<ElementType>>()};
+  }
+};
+
+// Specialization for a nested member destination keyword argument, as above.
+template <class Class, class Field>
+struct MakeHelper<KeywordArgument<TAG_DEST, MemberPath<Class, Field>>> {
+  typedef typename ElementType<Field>::value ElementType;
+  typedef KeywordContext<ElementType> ContextType;
+
+  static ContextType make_context() {
+    return {std::make_shared<StoreValue<ElementType>>()};
+  }
+};
+
 // Specializatinon for the case that we have exhausted all keyword arguments
 // and still have not encountered a typed action object or a target
 // destination. This means that the action must have no storage (e.g. is a void
@@ -83,14 +83,8 @@ void AssignmentHelper<TAG_DEFAULT>::assign(KeywordContext<T>* ctx,
 
 template <class T>
 void AssignmentHelper<TAG_CHOICES>::assign(
-    KeywordContext<T>* ctx, const std::initializer_list<T>& choices) {
-  std::vector<T> temp = choices;
-  ctx->action->set_choices(choices);
-}
-
-template <class T>
-void AssignmentHelper<TAG_CHOICES>::assign(KeywordContext<T>* ctx,
-                                           const std::vector<T>& choices) {
+    KeywordContext<T>* ctx,
+    const std::shared_ptr<const ChoiceSet<T>>& choices) {
   ctx->action->set_choices(choices);
 }
 
@@ -116,6 +110,25 @@ void AssignmentHelper<TAG_DEST>::assign(KeywordContext<T>* ctx,
   ctx->action->set_destination(model);
 }
 
+template <class T, class Class, class Field>
+void AssignmentHelper<TAG_DEST>::assign(KeywordContext<T>* ctx,
+                                        Field Class::*destination) {
+  ctx->action->set_destination(destination);
+}
+
+template <class T, class Class, class Field>
+void AssignmentHelper<TAG_DEST>::assign(
+    KeywordContext<T>* ctx, const MemberPath<Class, Field>& destination) {
+  ctx->action->set_destination(destination);
+}
+
+template <class T>
+void AssignmentHelper<TAG_DEST>::assign(
+    KeywordContext<T>* ctx,
+    const std::shared_ptr<StorageModel<T>>& destination) {
+  ctx->action->set_destination(destination);
+}
+
 template <class T>
 void AssignmentHelper<TAG_REQUIRED>::assign(KeywordContext<T>* ctx,
                                             bool value) {
@@ -100,6 +100,16 @@ void KWargs<bool>::DestinationField::operator=(bool* destination) {
   container_of(this, &KWargs<bool>::dest)->action->set_destination(destination);
 }
 
+KWargs<bool>::DestinationField::DestinationField(
+    const std::shared_ptr<StorageModel<bool>>& destination) {
+  (*this) = destination;
+}
+
+void KWargs<bool>::DestinationField::operator=(
+    const std::shared_ptr<StorageModel<bool>>& destination) {
+  container_of(this, &KWargs<bool>::dest)->action->set_destination(destination);
+}
+
 KWargs<bool>::RequiredField::RequiredField(bool value) {
   (*this) = value;
 }
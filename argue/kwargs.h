@@ -74,9 +74,14 @@ class KWargs {
     ChoicesField() {}
     ChoicesField(
         const std::initializer_list<T>& choices);  // NOLINT(runtime/explicit)
+    ChoicesField(std::vector<T> choices);          // NOLINT(runtime/explicit)
+    ChoicesField(  // NOLINT(runtime/explicit)
+        const std::shared_ptr<const ChoiceSet<T>>& choices);
 
     ChoicesField& operator=(const ChoicesField&) = delete;
     void operator=(const std::initializer_list<T>& choices);
+    void operator=(std::vector<T> choices);
+    void operator=(const std::shared_ptr<const ChoiceSet<T>>& choices);
   };
 
   class DestinationField {
@@ -89,6 +94,13 @@ class KWargs {
     template <class Allocator>
     DestinationField(
         std::vector<T, Allocator>* destination);  // NOLINT(runtime/explicit)
+    template <class Class, class Field>
+    DestinationField(Field Class::*destination);  // NOLINT(runtime/explicit)
+    template <class Class, class Field>
+    DestinationField(  // NOLINT(runtime/explicit)
+        const MemberPath<Class, Field>& destination);
+    DestinationField(  // NOLINT(runtime/explicit)
+        const std::shared_ptr<StorageModel<T>>& destination);
 
     DestinationField& operator=(const DestinationField&) = delete;
     void operator=(T* destination);
@@ -96,6 +108,11 @@ class KWargs {
     void operator=(std::list<T, Allocator>* destination);
     template <class Allocator>
     void operator=(std::vector<T, Allocator>* destination);
+    template <class Class, class Field>
+    void operator=(Field Class::*destination);
+    template <class Class, class Field>
+    void operator=(const MemberPath<Class, Field>& destination);
+    void operator=(const std::shared_ptr<StorageModel<T>>& destination);
   };
 
   class RequiredField {
@@ -198,6 +215,13 @@ class KWargs<bool> {
     template <class Allocator>
     DestinationField(
         std::vector<bool, Allocator>* destination);  // NOLINT(runtime/explicit)
+    template <class Class, class Field>
+    DestinationField(Field Class::*destination);  // NOLINT(runtime/explicit)
+    template <class Class, class Field>
+    DestinationField(  // NOLINT(runtime/explicit)
+        const MemberPath<Class, Field>& destination);
+    DestinationField(  // NOLINT(runtime/explicit)
+        const std::shared_ptr<StorageModel<bool>>& destination);
 
     DestinationField& operator=(const DestinationField&) = delete;
     void operator=(bool* destination);
@@ -205,6 +229,11 @@ class KWargs<bool> {
     void operator=(std::list<bool, Allocator>* destination);
     template <class Allocator>
     void operator=(std::vector<bool, Allocator>* destination);
+    template <class Class, class Field>
+    void operator=(Field Class::*destination);
+    template <class Class, class Field>
+    void operator=(const MemberPath<Class, Field>& destination);
+    void operator=(const std::shared_ptr<StorageModel<bool>>& destination);
   };
 
   class RequiredField {
@@ -111,11 +111,33 @@ KWargs<T>::ChoicesField::ChoicesField(const std::initializer_list<T>& choices) {
   (*this) = choices;
 }
 
+template <typename T>
+KWargs<T>::ChoicesField::ChoicesField(std::vector<T> choices) {
+  (*this) = std::move(choices);
+}
+
+template <typename T>
+KWargs<T>::ChoicesField::ChoicesField(
+    const std::shared_ptr<const ChoiceSet<T>>& choices) {
+  (*this) = choices;
+}
+
 template <typename T>
 void KWargs<T>::ChoicesField::operator=(
     const std::initializer_list<T>& choices) {
-  std::vector<T> temp = choices;
-  container_of(this, &KWargs<T>::choices)->action->set_choices(std::move(temp));
+  container_of(this, &KWargs<T>::choices)->action->set_choices(choices);
+}
+
+template <typename T>
+void KWargs<T>::ChoicesField::operator=(std::vector<T> choices) {
+  container_of(this, &KWargs<T>::choices)
+      ->action->set_choices(std::move(choices));
+}
+
+template <typename T>
+void KWargs<T>::ChoicesField::operator=(
+    const std::shared_ptr<const ChoiceSet<T>>& choices) {
+  container_of(this, &KWargs<T>::choices)->action->set_choices(choices);
 }
 
 template <typename T>
@@ -156,6 +178,44 @@ void KWargs<T>::DestinationField::operator=(
   container_of(this, &KWargs<T>::dest)->action->set_destination(destination);
 }
 
+template <typename T>
+template <class Class, class Field>
+KWargs<T>::DestinationField::DestinationField(Field Class::*destination) {
+  (*this) = destination;
+}
+
+template <typename T>
+template <class Class, class Field>
+KWargs<T>::DestinationField::DestinationField(
+    const MemberPath<Class, Field>& destination) {
+  (*this) = destination;
+}
+
+template <typename T>
+template <class Class, class Field>
+void KWargs<T>::DestinationField::operator=(Field Class::*destination) {
+  container_of(this, &KWargs<T>::dest)->action->set_destination(destination);
+}
+
+template <typename T>
+template <class Class, class Field>
+void KWargs<T>::DestinationField::operator=(
+    const MemberPath<Class, Field>& destination) {
+  container_of(this, &KWargs<T>::dest)->action->set_destination(destination);
+}
+
+template <typename T>
+KWargs<T>::DestinationField::DestinationField(
+    const std::shared_ptr<StorageModel<T>>& destination) {
+  (*this) = destination;
+}
+
+template <typename T>
+void KWargs<T>::DestinationField::operator=(
+    const std::shared_ptr<StorageModel<T>>& destination) {
+  container_of(this, &KWargs<T>::dest)->action->set_destination(destination);
+}
+
 template <typename T>
 KWargs<T>::RequiredField::RequiredField(bool value) {
   (*this) = value;
@@ -230,4 +290,26 @@ void KWargs<bool>::DestinationField::operator=(
   container_of(this, &KWargs<bool>::dest)->action->set_destination(destination);
 }
 
+template <class Class, class Field>
+KWargs<bool>::DestinationField::DestinationField(Field Class::*destination) {
+  (*this) = destination;
+}
+
+template <class Class, class Field>
+KWargs<bool>::DestinationField::DestinationField(
+    const MemberPath<Class, Field>& destination) {
+  (*this) = destination;
+}
+
+template <class Class, class Field>
+void KWargs<bool>::DestinationField::operator=(Field Class::*destination) {
+  container_of(this, &KWargs<bool>::dest)->action->set_destination(destination);
+}
+
+template <class Class, class Field>
+void KWargs<bool>::DestinationField::operator=(
+    const MemberPath<Class, Field>& destination) {
+  container_of(this, &KWargs<bool>::dest)->action->set_destination(destination);
+}
+
 }  // namespace argue
@@ -10,48 +10,122 @@ namespace argue {
 //                          String Parsing
 // =============================================================================
 
-int parse(const std::string& str, uint8_t* value) {
+// Return the value of `c` as a digit, in any radix up to 16, or a value of at
+// least 16 if `c` is not a digit.
+static inline unsigned digit_value(char c) {
+  unsigned decimal = static_cast<unsigned char>(c) - '0';
+  if (decimal < 10) {
+    return decimal;
+  }
+  // NOTE(josh): setting 0x20 maps upper case letters to lower case
+  unsigned letter = (static_cast<unsigned char>(c) | 0x20) - 'a';
+  if (letter < 6) {
+    return letter + 10;
+  }
+  return 16;
+}
+
+int parse_magnitude(const StringPiece& str, uint64_t limit, uint64_t* value) {
+  size_t idx = 0;
+  unsigned radix = 10;
+  if (str.size() > 2 && str[0] == '0') {
+    switch (str[1]) {
+      case 'x':
+      case 'X':
+        radix = 16;
+        idx = 2;
+        break;
+      case 'o':
+      case 'O':
+        radix = 8;
+        idx = 2;
+        break;
+      case 'b':
+      case 'B':
+        radix = 2;
+        idx = 2;
+        break;
+      default:
+        break;
+    }
+  }
+  if (idx == str.size()) {
+    return -1;
+  }
+
+  // Accumulating another digit overflows `limit` if the accumulator exceeds
+  // `cutoff`, or equals it and the digit exceeds `cutlim`.
+  const uint64_t cutoff = limit / radix;
+  const unsigned cutlim = static_cast<unsigned>(limit % radix);
+  uint64_t accum = 0;
+  bool after_digit = false;
+  for (; idx < str.size(); ++idx) {
+    char c = str[idx];
+    if (c == '_' || c == '\'') {
+      // A separator must sit between two digits
+      if (!after_digit || idx + 1 == str.size()) {
+        return -1;
+      }
+      after_digit = false;
+      continue;
+    }
+    unsigned digit = digit_value(c);
+    if (digit >= radix) {
+      return -1;
+    }
+    if (accum > cutoff || (accum == cutoff && digit > cutlim)) {
+      return -1;
+    }
+    accum = accum * radix + digit;
+    after_digit = true;
+  }
+
+  *value = accum;
+  return 0;
+}
+
+int parse(const StringPiece& str, uint8_t* value) {
   return parse_unsigned(str, value);
 }
 
-int parse(const std::string& str, uint16_t* value) {
+int parse(const StringPiece& str, uint16_t* value) {
   return parse_unsigned(str, value);
 }
 
-int parse(const std::string& str, uint32_t* value) {
+int parse(const StringPiece& str, uint32_t* value) {
   return parse_unsigned(str, value);
 }
 
-int parse(const std::string& str, uint64_t* value) {
+int parse(const StringPiece& str, uint64_t* value) {
   return parse_unsigned(str, value);
 }
 
-int parse(const std::string& str, int8_t* value) {
+int parse(const StringPiece& str, int8_t* value) {
   return parse_signed(str, value);
 }
 
-int parse(const std::string& str, int16_t* value) {
+int parse(const StringPiece& str, int16_t* value) {
   return parse_signed(str, value);
 }
 
-int parse(const std::string& str, int32_t* value) {
+int parse(const StringPiece& str, int32_t* value) {
   return parse_signed(str, value);
 }
 
-int parse(const std::string& str, int64_t* value) {
+int parse(const StringPiece& str, int64_t* value) {
   return parse_signed(str, value);
 }
 
-int parse(const std::string& str, float* value) {
+int parse(const StringPiece& str, float* value) {
   return parse_float(str, value);
 }
 
-int parse(const std::string& str, double* value) {
+int parse(const StringPiece& str, double* value) {
   return parse_float(str, value);
 }
 
-int parse(const std::string& str, bool* value) {
-  std::string lower = string::to_lower(str);
+int parse(const StringPiece& str, bool* value) {
+  std::string lower = string::to_lower(str.to_string());
   if (lower == "true" || lower == "t" || lower == "yes" || lower == "y" ||
       lower == "on" || lower == "1") {
     *value = true;
@@ -65,6 +139,55 @@ int parse(const std::string& str, bool* value) {
   }
 }
 
+int parse(const StringPiece& str, std::string* value) {
+  value->assign(str.data(), str.size());
+  return 0;
+}
+
+int parse(const std::string& str, uint8_t* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, uint16_t* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, uint32_t* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, uint64_t* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, int8_t* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, int16_t* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, int32_t* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, int64_t* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, float* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, double* value) {
+  return parse(StringPiece(str), value);
+}
+
+int parse(const std::string& str, bool* value) {
+  return parse(StringPiece(str), value);
+}
+
 int parse(const std::string& str, std::string* value) {
   *value = str;
   return 0;
@@ -89,7 +212,7 @@ int string_to_nargs(const std::string& str) {
   return string_to_nargs(str[0]);
 }
 
-ArgType get_arg_type(const std::string arg) {
+ArgType get_arg_type(const StringPiece& arg) {
   if (arg.size() > 1 && arg[0] == '-') {
     if (arg.size() > 2 && arg[1] == '-') {
       return LONG_FLAG;
@@ -3,31 +3,64 @@
 
 #include <cmath>
 #include <cstdint>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "argue/enum_table.h"
+#include "argue/util.h"
+
 namespace argue {
 
 // =============================================================================
 //                          String Parsing
 // =============================================================================
 
-// Parse a base-10 string as into a signed integer. Matches strings of the
-// form `[-?]\d+`.
-template <typename T>
-int parse_signed(const std::string& str, T* value);
-
-// Parse a base-10 string into an unsigned integer. Matches strings of the
-// form `\d+`.
+// Parse the magnitude of an integer, without a sign, into `value`.
+/* The digits may be preceded by a radix prefix: `0x` (hexadecimal), `0o`
+ * (octal) or `0b` (binary), otherwise they are decimal. Digits may be
+ * grouped with a separator, `_` or `'`, between any two of them (e.g.
+ * `1_000_000` or `0xffff_ffff`). Returns 0 on success, or -1 if the string is
+ * malformed or its value exceeds `limit`, in which case `value` is not
+ * modified. Does not allocate. */
+int parse_magnitude(const StringPiece& str, uint64_t limit, uint64_t* value);
+
+// Parse a string into a signed integer. Matches strings of the form
+// `-?<magnitude>` (see `parse_magnitude`). Returns -1 if the string is
+// malformed or its value does not fit in `T`.
 template <typename T>
-int parse_unsigned(const std::string& str, T* value);
+int parse_signed(const StringPiece& str, T* value);
 
-// Parse a real-number string into a floating point value. Matches strings
-// of the form `[-?]\d+\.?\d*`
+// Parse a string into an unsigned integer. Matches strings of the form
+// `<magnitude>` (see `parse_magnitude`). Returns -1 if the string is
+// malformed or its value does not fit in `T`.
 template <typename T>
-int parse_float(const std::string& str, T* value);
+int parse_unsigned(const StringPiece& str, T* value);
+
+// Parse a real-number string into the nearest floating point value.
+/* Matches strings of the form `-?(\d+\.?\d*|\.\d+)([eE][-+]?\d+)?`, or
+ * `-?(inf|infinity|nan)` in any case. The result is correctly rounded (ties to
+ * even), so any value printed with enough digits parses back exactly. Values
+ * too large for the type become infinity and values too small become zero.
+ * Returns -1 if the string is malformed, in which case `value` is not
+ * modified. Does not depend on the locale. */
+int parse_float(const StringPiece& str, float* value);
+int parse_float(const StringPiece& str, double* value);
+
+int parse(const StringPiece& str, uint8_t* value);
+int parse(const StringPiece& str, uint16_t* value);
+int parse(const StringPiece& str, uint32_t* value);
+int parse(const StringPiece& str, uint64_t* value);
+int parse(const StringPiece& str, int8_t* value);
+int parse(const StringPiece& str, int16_t* value);
+int parse(const StringPiece& str, int32_t* value);
+int parse(const StringPiece& str, int64_t* value);
+int parse(const StringPiece& str, float* value);
+int parse(const StringPiece& str, double* value);
+int parse(const StringPiece& str, bool* value);
+int parse(const StringPiece& str, std::string* value);
 
 int parse(const std::string& str, uint8_t* value);
 int parse(const std::string& str, uint16_t* value);
@@ -51,6 +84,13 @@ int parse(const std::string& str, std::list<T, Allocator>* ptr);
 template <typename T, class Allocator>
 int parse(const std::string& str, std::vector<T, Allocator>* ptr);
 
+// Parse an argument token into `value`.
+/* Types which provide a `StringPiece` overload of `parse` are parsed directly
+ * out of the token. Types which only provide a `std::string` overload are
+ * parsed from a temporary copy of the token. */
+template <typename T>
+int parse_token(const StringPiece& token, T* value);
+
 // Tokens in an argument list are one of these.
 enum ArgType { SHORT_FLAG = 0, LONG_FLAG = 1, POSITIONAL = 2 };
 
@@ -58,7 +98,7 @@ enum ArgType { SHORT_FLAG = 0, LONG_FLAG = 1, POSITIONAL = 2 };
 //  * SHORT_FLAG if it is of the form `-[^-]`
 //  * LONG_FLAG if it is of the form `--.+`
 //  * POSITIONAL otherwise
-ArgType get_arg_type(const std::string arg);
+ArgType get_arg_type(const StringPiece& arg);
 
 // Sentinel integer values used to indicate special `nargs`.
 enum SentinelNargs {
@@ -6,104 +6,33 @@
 namespace argue {
 
 template <typename T>
-int parse_signed(const std::string& str, T* value) {
-  *value = 0;
-
-  size_t idx = 0;
-  T multiplier = 1;
-
-  if (str[0] == '-') {
-    multiplier = -std::pow(10, str.size() - 2);
-    ++idx;
-  } else {
-    multiplier = std::pow(10, str.size() - 1);
-  }
-
-  for (; idx < str.size(); idx++) {
-    if ('0' <= str[idx] && str[idx] <= '9') {
-      *value += multiplier * static_cast<T>(str[idx] - '0');
-      multiplier /= 10;
-    } else {
-      return -1;
-    }
+int parse_signed(const StringPiece& str, T* value) {
+  bool negative = (!str.empty() && str[0] == '-');
+  // NOTE(josh): the magnitude of the most negative value is one more than
+  // the most positive value.
+  uint64_t limit = static_cast<uint64_t>(std::numeric_limits<T>::max()) +
+                   (negative ? 1 : 0);
+  uint64_t magnitude = 0;
+  if (parse_magnitude(negative ? str.substr(1) : str, limit, &magnitude)) {
+    return -1;
   }
-
-  return 0;
-}
-
-template <typename T>
-int parse_unsigned(const std::string& str, T* value) {
-  *value = 0;
-
-  T multiplier = std::pow(10, str.size() - 1);
-  for (size_t idx = 0; idx < str.size(); idx++) {
-    if ('0' <= str[idx] && str[idx] <= '9') {
-      *value += multiplier * static_cast<T>(str[idx] - '0');
-      multiplier /= 10;
-    } else {
-      return -1;
-    }
+  if (negative && magnitude > 0) {
+    // NOTE(josh): `magnitude - 1` is representable in T, where `magnitude`
+    // may not be.
+    *value = static_cast<T>(-static_cast<T>(magnitude - 1) - 1);
+  } else {
+    *value = static_cast<T>(magnitude);
   }
-
   return 0;
 }
 
 template <typename T>
-int parse_float(const std::string& str, T* value) {
-  *value = 0.0;
-
-  size_t decimal_idx = str.find('.');
-  if (decimal_idx == std::string::npos) {
-    decimal_idx = str.size();
-  }
-
-  int64_t integral_part = 0;
-  int64_t fractional_part = 0;
-  int64_t denominator = 10;
-
-  size_t idx = 0;
-  int32_t multiplier = 1;
-
-  if (str[0] == '-') {
-    multiplier = -std::pow(10, decimal_idx - 2);
-    ++idx;
-  } else {
-    multiplier = std::pow(10, decimal_idx - 1);
+int parse_unsigned(const StringPiece& str, T* value) {
+  uint64_t magnitude = 0;
+  if (parse_magnitude(str, std::numeric_limits<T>::max(), &magnitude)) {
+    return -1;
   }
-
-  for (; idx < decimal_idx; ++idx) {
-    if ('0' <= str[idx] && str[idx] <= '9') {
-      integral_part += multiplier * static_cast<uint64_t>(str[idx] - '0');
-      multiplier /= 10;
-    } else {
-      return -1;
-    }
-  }
-
-  if (decimal_idx == str.size()) {
-    *value = static_cast<T>(integral_part);
-    return 0;
-  }
-
-  denominator = std::pow(10, str.size() - decimal_idx);
-  if (str[0] == '-') {
-    multiplier = -denominator / 10;
-  } else {
-    multiplier = denominator / 10;
-  }
-
-  ++idx;
-  for (; idx < str.size(); ++idx) {
-    if ('0' <= str[idx] && str[idx] <= '9') {
-      fractional_part += multiplier * static_cast<uint64_t>(str[idx] - '0');
-      multiplier /= 10;
-    } else {
-      return -1;
-    }
-  }
-
-  *value = static_cast<T>(integral_part) +
-           static_cast<T>(fractional_part) / static_cast<T>(denominator);
+  *value = static_cast<T>(magnitude);
   return 0;
 }
 
@@ -122,4 +51,22 @@ int parse(const std::string& str, std::vector<T, Allocator>* ptr) {
   return -1;
 }
 
+// Selected when there is a `parse()` overload accepting a `StringPiece`
+template <typename T>
+auto parse_token_impl(const StringPiece& token, T* value, int)
+    -> decltype(parse(token, value)) {
+  return parse(token, value);
+}
+
+// Selected when `parse()` is only available for `std::string`
+template <typename T>
+int parse_token_impl(const StringPiece& token, T* value, long) {
+  return parse(token.to_string(), value);
+}
+
+template <typename T>
+int parse_token(const StringPiece& token, T* value) {
+  return parse_token_impl(token, value, 0);
+}
+
 }  // namespace argue
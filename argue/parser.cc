@@ -2,8 +2,11 @@
 #include "argue/parser.h"
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <thread>
 
+#include "argue/elf_note.h"
 #include "argue/exception.h"
 #include "argue/parse.h"
 #include "tangent/json/type_registry.h"
@@ -24,45 +27,57 @@ namespace argue {
 std::string get_flag_usage(const std::string& short_flag,
                            const std::string& long_flag,
                            const std::shared_ptr<ActionBase>& action) {
-  std::stringstream token;
-  if (!action->is_required()) {
-    token << "[";
-  }
-
-  std::list<std::string> parts;
-  std::list<std::string> names;
-  if (short_flag.size()) {
-    names.emplace_back(short_flag);
-  }
-
   std::string default_metavar = "??";
   if (!long_flag.empty()) {
-    names.emplace_back(long_flag);
     default_metavar = long_flag.substr(2);
   }
 
-  std::string name = string::join(names, "/");
-
   int nargs = action->get_nargs(EXACTLY_ONE);
   std::string metavar = action->get_metavar(string::to_upper(default_metavar));
+
+  std::string token;
+  token.reserve(short_flag.size() + long_flag.size() + 2 * metavar.size() +
+                16);
+  if (!action->is_required()) {
+    token += '[';
+  }
+
+  // NOTE(josh): any other `nargs` (e.g. ZERO_NARGS) has no parts, so only
+  // the brackets are written.
+  bool has_name = nargs > 0 || nargs == ONE_OR_MORE || nargs == ZERO_OR_ONE ||
+                  nargs == ZERO_OR_MORE || nargs == EXACTLY_ONE;
+  if (has_name) {
+    token += short_flag;
+    if (!short_flag.empty() && !long_flag.empty()) {
+      token += '/';
+    }
+    token += long_flag;
+  }
+
   if (nargs == ONE_OR_MORE) {
-    parts = {name, metavar + " [..]"};
+    token += ' ';
+    token += metavar;
+    token += " [..]";
   } else if (nargs == ZERO_OR_ONE) {
-    parts = {name, "[" + metavar + "]"};
+    token += " [";
+    token += metavar;
+    token += ']';
   } else if (nargs == ZERO_OR_MORE) {
-    parts = {name, "[" + metavar + " [..]]"};
-  } else if (nargs == EXACTLY_ONE) {
-    parts = {name};
+    token += " [";
+    token += metavar;
+    token += " [..]]";
   } else if (nargs > 0) {
-    parts = {name, metavar, metavar, ".."};
+    token += ' ';
+    token += metavar;
+    token += ' ';
+    token += metavar;
+    token += " ..";
   }
 
-  token << string::join(parts, " ");
   if (!action->is_required()) {
-    token << "]";
+    token += ']';
   }
-
-  return token.str();
+  return token;
 }
 
 std::string get_positional_usage(const std::string& name,
@@ -88,36 +103,83 @@ std::string get_positional_usage(const std::string& name,
 const ColumnSpec kDefaultColumns = {4, 16, 60};
 
 std::string repeat(const std::string bit, int n) {
-  std::stringstream out;
-  for (int i = 0; i < n; i++) {
-    out << bit;
+  std::string out;
+  if (n > 0) {
+    out.reserve(bit.size() * n);
+    for (int i = 0; i < n; i++) {
+      out += bit;
+    }
   }
-  return out.str();
+  return out;
+}
+
+static bool is_wrap_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
 }
 
 // http://rosettacode.org/wiki/Word_wrap#C.2B.2B
+/* Words are scanned in place rather than extracted through a stream, and the
+ * output is built in a single buffer sized to the input. */
 std::string wrap(const std::string text, size_t line_length) {
   if (line_length == 0) {
     return text;
   }
-  std::istringstream words(text);
-  std::ostringstream wrapped;
-  std::string word;
-
-  if (words >> word) {
-    wrapped << word;
-    size_t space_left = line_length - word.length();
-    while (words >> word) {
-      if (space_left < word.length() + 1) {
-        wrapped << '\n' << word;
-        space_left = line_length - word.length();
-      } else {
-        wrapped << ' ' << word;
-        space_left -= word.length() + 1;
-      }
+  std::string wrapped;
+  wrapped.reserve(text.size());
+
+  size_t space_left = line_length;
+  const char* iter = text.data();
+  const char* end = text.data() + text.size();
+  while (iter < end) {
+    while (iter < end && is_wrap_space(*iter)) {
+      ++iter;
+    }
+    const char* word = iter;
+    while (iter < end && !is_wrap_space(*iter)) {
+      ++iter;
+    }
+    size_t word_length = iter - word;
+    if (word_length == 0) {
+      break;
+    }
+
+    if (wrapped.empty()) {
+      // NOTE(josh): nothing to separate from the first word
+    } else if (space_left < word_length + 1) {
+      wrapped += '\n';
+      space_left = line_length;
+    } else {
+      wrapped += ' ';
+      space_left -= 1;
+    }
+    // A word longer than the line gets a line to itself
+    space_left = word_length < space_left ? space_left - word_length : 0;
+    wrapped.append(word, word_length);
+  }
+  return wrapped;
+}
+
+// The table of the last call to `register_help_text()`
+static const PrecomputedHelp* g_help_begin = nullptr;
+static const PrecomputedHelp* g_help_end = nullptr;
+
+bool register_help_text(const PrecomputedHelp* begin,
+                        const PrecomputedHelp* end) {
+  g_help_begin = begin;
+  g_help_end = end;
+  return true;
+}
+
+// Return the registered help for `command`, or nullptr if there is none
+static const PrecomputedHelp* find_help_text(const std::string& command) {
+  for (const PrecomputedHelp* entry = g_help_begin; entry < g_help_end;
+       ++entry) {
+    if (command == entry->command) {
+      return entry;
     }
   }
-  return wrapped.str();
+  return nullptr;
 }
 
 VersionString::VersionString(int major, int minor, int patch) {
@@ -133,11 +195,53 @@ VersionString::VersionString(int major, int minor, int patch, const char* tag,
   this->assign(strstrm.str());
 }
 
+// =============================================================================
+//                              Parse Session
+// =============================================================================
+
+ParseSession::ParseSession(size_t num_flags, size_t num_positionals)
+    : inline_words_{0, 0},
+      words_(inline_words_),
+      next_positional_(0),
+      num_positionals_(num_positionals) {
+  size_t num_words = (num_flags + 63) / 64;
+  if (num_words > kInlineWords) {
+    heap_words_.resize(num_words, 0);
+    words_ = heap_words_.data();
+  }
+}
+
+bool ParseSession::is_flag_consumed(size_t flag_idx) const {
+  return (words_[flag_idx / 64] >> (flag_idx % 64)) & 0x01;
+}
+
+void ParseSession::consume_flag(size_t flag_idx) {
+  words_[flag_idx / 64] |= (uint64_t(1) << (flag_idx % 64));
+}
+
+bool ParseSession::has_positional() const {
+  return next_positional_ < num_positionals_;
+}
+
+size_t ParseSession::pop_positional() {
+  return next_positional_++;
+}
+
+size_t ParseSession::next_positional() const {
+  return next_positional_;
+}
+
 // =============================================================================
 //                                 Parser
 // =============================================================================
 
-Parser::Parser(const Metadata& meta) : meta_(meta) {
+Parser::Parser(const Metadata& meta)
+    : meta_(meta),
+      frozen_(false),
+      usage_ready_(false),
+      help_ready_(false),
+      help_columns_(kDefaultColumns),
+      help_depth_(0) {
   if (meta.add_help) {
     this->add_argument<void>("-h", "--help", {.action = "help"});
   }
@@ -162,6 +266,7 @@ std::shared_ptr<Subparsers> Parser::add_subparsers(
   spec.metavar = name;
 
   positionals_.emplace_back(action);
+  frozen_ = false;
   PositionalHelp help{.name = name, .action = action};
 
   positional_help_.emplace_back(help);
@@ -169,51 +274,246 @@ std::shared_ptr<Subparsers> Parser::add_subparsers(
   return action;
 }
 
-int Parser::parse_args(int argc, char** argv, std::ostream* out) {
-  if (argc < 0) {
-    return PARSE_EXCEPTION;
+void Parser::freeze() {
+  if (!frozen_) {
+    validate();
+    short_index_.fill(-1);
+    for (const FlagStore& store : flags_) {
+      if (!store.short_flag.empty()) {
+        short_index_[static_cast<unsigned char>(store.short_flag[1])] =
+            static_cast<int32_t>(store.index);
+      }
+    }
+
+    // NOTE(josh): the registration map is already sorted
+    long_index_.clear();
+    long_index_.reserve(long_flags_.size());
+    for (const auto& pair : long_flags_) {
+      const FlagStore& store = flags_[pair.second];
+      long_index_.push_back({StringPiece(store.long_flag), store.index});
+    }
+
+    target_type_ = TypeId();
+    for (const FlagStore& store : flags_) {
+      merge_target_type(store.action.get());
+    }
+    for (const auto& action : positionals_) {
+      merge_target_type(action.get());
+    }
+    usage_ready_ = false;
+    help_ready_ = false;
+    frozen_ = true;
+  }
+
+  // NOTE(josh): lazy subparsers are frozen when they are built
+  for (const auto& sub : subcommand_help_) {
+    for (const auto& entry : *sub) {
+      if (entry->is_built()) {
+        entry->get_parser()->freeze();
+      }
+    }
+  }
+}
+
+void Parser::merge_target_type(const ActionBase* action) {
+  TypeId action_type = action->get_target_type();
+  if (!action_type) {
+    return;
+  }
+  ARGUE_ASSERT(CONFIG_ERROR, !target_type_ || target_type_ == action_type)
+      << "The member destinations of parser '" << meta_.name
+      << "' belong to more than one class. All member destinations of a "
+         "parser must be members of the same target.";
+  target_type_ = action_type;
+}
+
+bool Parser::is_frozen() const {
+  return frozen_;
+}
+
+const FlagStore* Parser::find_short_flag(char c) const {
+  unsigned char idx = static_cast<unsigned char>(c);
+  if (idx >= short_index_.size() || short_index_[idx] < 0) {
+    return nullptr;
+  }
+  return &flags_[short_index_[idx]];
+}
+
+static const StringPiece& long_flag_key(const LongFlagEntry& entry) {
+  return entry.name;
+}
+
+static bool long_flag_less(const LongFlagEntry& entry,
+                           const StringPiece& flag) {
+  return entry.name < flag;
+}
+
+const FlagStore* Parser::find_long_flag(const StringPiece& flag) const {
+  auto iter = std::lower_bound(long_index_.begin(), long_index_.end(), flag,
+                               long_flag_less);
+  if (iter == long_index_.end() || iter->name != flag) {
+    return nullptr;
+  }
+  return &flags_[iter->index];
+}
+
+// Print an exception that terminated a parse to the parse log
+static int report_exception(const Exception& ex, std::ostream* out) {
+  (*out) << Exception::to_string(ex.typeno) << ": ";
+  (*out) << ex.message << "\n";
+  if (ex.typeno == Exception::BUG) {
+    (*out) << ex.stack_trace;
   }
+  return PARSE_EXCEPTION;
+}
+
+// Print a parse error to the parse log
+static int report_error(const ParseError& error, std::ostream* out) {
+  (*out) << Exception::to_string(error.type) << ": ";
+  (*out) << error.message << "\n";
+  (*out) << error.usage;
+  return PARSE_EXCEPTION;
+}
+
+bool Parser::freeze_for_parse(std::ostream* out) {
+#if ARGUE_EXCEPTIONS
+  try {
+    freeze();
+    return true;
+  } catch (const Exception& ex) {
+    report_exception(ex, out);
+    return false;
+  }
+#else
+  freeze();
+  return true;
+#endif
+}
+
+// Make views of the arguments in argv, excluding argv[0]
+static void make_tokens(int argc, char** argv,
+                        std::vector<StringPiece>* tokens) {
+  // NOTE(josh): the tokens are views into argv, no argument text is copied
+  // until an action stores a value.
+  if (argc > 1) {
+    tokens->reserve(argc - 1);
+  }
+  for (size_t i = 1; i < static_cast<size_t>(argc); ++i) {
+    tokens->emplace_back(argv[i]);
+  }
+}
+
+int Parser::parse_args(int argc, char** argv, std::ostream* out) {
+  return parse_args(ParseTarget(), argc, argv, out);
+}
+
+int Parser::parse_args(int argc, char** argv, std::ostream* out) const {
+  return parse_args(ParseTarget(), argc, argv, out);
+}
+
+int Parser::parse_args(const ParseTarget& target, int argc, char** argv,
+                       std::ostream* out) {
   if (argc > 0) {
     if (meta_.name.empty()) {
       meta_.name = argv[0];
     }
   }
+  if (!freeze_for_parse(out)) {
+    return PARSE_EXCEPTION;
+  }
+  return static_cast<const Parser*>(this)->parse_args(target, argc, argv,
+                                                      out);
+}
 
-  std::list<std::string> args;
-  for (size_t i = 1; i < static_cast<size_t>(argc); ++i) {
-    args.emplace_back(argv[i]);
+int Parser::parse_args(const ParseTarget& target, int argc, char** argv,
+                       std::ostream* out) const {
+  if (argc < 0) {
+    return PARSE_EXCEPTION;
   }
 
-  return parse_args(&args, out);
+  std::vector<StringPiece> tokens;
+  make_tokens(argc, argv, &tokens);
+  TokenStream args{tokens.data(), tokens.data() + tokens.size()};
+  return parse_args(target, &args, out);
 }
 
 int Parser::parse_args(const std::initializer_list<std::string>& init_list,
                        std::ostream* out) {
-  std::list<std::string> args = init_list;
-  return parse_args(&args, out);
+  return parse_args(ParseTarget(), init_list, out);
 }
 
-static AutoCompleteContext maybe_autocomplete(std::list<std::string>* args) {
-  AutoCompleteContext ctx{};
+int Parser::parse_args(const std::initializer_list<std::string>& init_list,
+                       std::ostream* out) const {
+  return parse_args(ParseTarget(), init_list, out);
+}
 
-  const char* value = nullptr;
+int Parser::parse_args(const ParseTarget& target,
+                       const std::initializer_list<std::string>& init_list,
+                       std::ostream* out) {
+  if (!freeze_for_parse(out)) {
+    return PARSE_EXCEPTION;
+  }
+  return static_cast<const Parser*>(this)->parse_args(target, init_list, out);
+}
 
-  value = getenv("_ARGUE_DEBUG");
-  // TODO(josh): intentional memory leak :(.
-  if (value && std::stoi(value) == 1) {
-    ctx.debug = new std::ofstream{"/tmp/argue-complete.log"};
-  } else {
-    ctx.debug = new NullStream{};
+int Parser::parse_args(const ParseTarget& target,
+                       const std::initializer_list<std::string>& init_list,
+                       std::ostream* out) const {
+  std::vector<StringPiece> tokens{init_list.begin(), init_list.end()};
+  TokenStream args{tokens.data(), tokens.data() + tokens.size()};
+  return parse_args(target, &args, out);
+}
+
+int Parser::parse_args(std::list<std::string>* args, std::ostream* out) {
+  if (!freeze_for_parse(out)) {
+    return PARSE_EXCEPTION;
   }
+  return static_cast<const Parser*>(this)->parse_args(args, out);
+}
+
+int Parser::parse_args(std::list<std::string>* args,
+                       std::ostream* out) const {
+  std::vector<StringPiece> tokens{args->begin(), args->end()};
+  TokenStream stream{tokens.data(), tokens.data() + tokens.size()};
+  int result = parse_args(&stream, out);
+
+  // Remove the arguments that were consumed by the parser, preserving the
+  // contract that the list is left holding whatever was not consumed.
+  auto consumed_end = args->begin();
+  std::advance(consumed_end, stream.begin() - tokens.data());
+  args->erase(args->begin(), consumed_end);
+  return result;
+}
 
+static AutoCompleteContext maybe_autocomplete(const TokenStream& args) {
+  AutoCompleteContext ctx{};
+  ctx.debug = nullptr;
+
+  const char* value = nullptr;
+
+  // NOTE(josh): check this first so that an ordinary parse does not touch
+  // any shared or heap state.
   value = getenv("_ARGUECOMPLETE");
   if (!value) {
     return ctx;
   }
+  if (std::strcmp(value, "spec") == 0) {
+    ctx.write_spec = true;
+    return ctx;
+  }
   if (std::strcmp(value, "1") != 0) {
     return ctx;
   }
 
+  value = getenv("_ARGUE_DEBUG");
+  // TODO(josh): intentional memory leak :(. The process exits at the end of
+  // completion anyway.
+  if (value && std::strcmp(value, "1") == 0) {
+    ctx.debug = new std::ofstream{"/tmp/argue-complete.log"};
+  } else {
+    ctx.debug = new NullStream{};
+  }
+
   // NOTE(josh): __gnu_cxx::stdio_filebuf documentation says it will close the
   // file descriptor on destruction.
   // __gnu_cxx::stdio_filebuf<char> gnu_filebuf(dup(9), std::ios::out);
@@ -232,7 +532,7 @@ static AutoCompleteContext maybe_autocomplete(std::list<std::string>* args) {
   }
 
   (*ctx.debug) << "args: [\n";
-  for (const std::string arg : *args) {
+  for (const StringPiece& arg : args) {
     (*ctx.debug) << "  " << arg << "\n";
   }
   (*ctx.debug) << "]\n";
@@ -251,54 +551,224 @@ static AutoCompleteContext maybe_autocomplete(std::list<std::string>* args) {
     return ctx;
   }
 
-  size_t comp_word_idx = std::stoul(value);
-  if (args->size() < comp_word_idx) {
+  // NOTE(josh): COMP_CWORD counts the program name, which is not part of the
+  // token stream.
+  size_t comp_word_idx = std::strtoul(value, nullptr, 10);
+  if (comp_word_idx < 1 || args.size() < comp_word_idx) {
     (*ctx.debug) << "CWORD > argn" << std::endl;
     return ctx;
   }
 
-  auto iter = args->begin();
-  for (size_t idx = 0; idx < comp_word_idx - 1; idx++) {
-    iter++;
-  }
-  (*ctx.debug) << "Stored pointer to comp_word: " << (*iter) << "\n";
+  (*ctx.debug) << "Stored index of comp_word: " << comp_word_idx - 1 << " ("
+               << *(args.begin() + comp_word_idx - 1) << ")\n";
   ctx.debug->flush();
 
   ctx.active = true;
-  ctx.comp_word = iter;
+  ctx.comp_word = args.index() + comp_word_idx - 1;
   return ctx;
 }
 
-int Parser::parse_args(std::list<std::string>* args, std::ostream* out) {
+int Parser::parse_args(TokenStream* args, std::ostream* out) {
+  return parse_args(ParseTarget(), args, out);
+}
+
+int Parser::parse_args(TokenStream* args, std::ostream* out) const {
+  return parse_args(ParseTarget(), args, out);
+}
+
+int Parser::parse_args(const ParseTarget& target, TokenStream* args,
+                       std::ostream* out) {
+  if (!freeze_for_parse(out)) {
+    return PARSE_EXCEPTION;
+  }
+  return static_cast<const Parser*>(this)->parse_args(target, args, out);
+}
+
+int Parser::parse_args(const ParseTarget& target, TokenStream* args,
+                       std::ostream* out) const {
+  ParseError error{};
+  ParseResult result = PARSE_EXCEPTION;
+#if ARGUE_EXCEPTIONS
   try {
+    result = try_parse_args(target, args, &error, out);
+  } catch (const Exception& ex) {
+    return report_exception(ex, out);
+  }
+#else
+  result = try_parse_args(target, args, &error, out);
+#endif
+  if (result == PARSE_EXCEPTION) {
+    return report_error(error, out);
+  }
+  return result;
+}
+
+ParseResult Parser::try_parse_args(int argc, char** argv, ParseError* error,
+                                   std::ostream* out) const {
+  return try_parse_args(ParseTarget(), argc, argv, error, out);
+}
+
+ParseResult Parser::try_parse_args(
+    const std::initializer_list<std::string>& init_list, ParseError* error,
+    std::ostream* out) const {
+  return try_parse_args(ParseTarget(), init_list, error, out);
+}
+
+ParseResult Parser::try_parse_args(TokenStream* args, ParseError* error,
+                                   std::ostream* out) const {
+  return try_parse_args(ParseTarget(), args, error, out);
+}
+
+ParseResult Parser::try_parse_args(const ParseTarget& target, int argc,
+                                   char** argv, ParseError* error,
+                                   std::ostream* out) const {
+  std::vector<StringPiece> tokens;
+  make_tokens(argc, argv, &tokens);
+  TokenStream args{tokens.data(), tokens.data() + tokens.size()};
+  return try_parse_args(target, &args, error, out);
+}
+
+ParseResult Parser::try_parse_args(
+    const ParseTarget& target,
+    const std::initializer_list<std::string>& init_list, ParseError* error,
+    std::ostream* out) const {
+  std::vector<StringPiece> tokens{init_list.begin(), init_list.end()};
+  TokenStream args{tokens.data(), tokens.data() + tokens.size()};
+  return try_parse_args(target, &args, error, out);
+}
+
+ParseResult Parser::try_parse_args(const ParseTarget& target,
+                                   TokenStream* args, ParseError* error,
+                                   std::ostream* out) const {
+  ParseContext ctx{};
+  ctx.out = out;
+  ctx.error = error;
+  ctx.target = target;
+  ctx.auto_complete = maybe_autocomplete(*args);
+  if (ctx.auto_complete.write_spec) {
+    write_completion_spec();
+    exit(0);
+  }
+  // NOTE(josh): completion works on the words as the shell sees them, so
+  // response files are not expanded while completing.
+  if (meta_.response_files && !ctx.auto_complete.active) {
+    args->expand_response_files();
+  }
+  return static_cast<ParseResult>(parse_args_impl(args, ctx));
+}
+
+// Number of command lines claimed by a batch worker at a time. Small enough
+// to balance uneven lines across workers, large enough that the workers do
+// not contend on the shared cursor.
+static const size_t kBatchChunkSize = 32;
+
+void Parser::parse_batch_lines(
+    const std::vector<std::vector<std::string>>& command_lines,
+    const std::function<ParseTarget(size_t)>& get_target, size_t begin,
+    size_t end, std::vector<StringPiece>* tokens, std::ostream* out,
+    std::vector<BatchResult>* results) const {
+  for (size_t idx = begin; idx < end; ++idx) {
+    const std::vector<std::string>& line = command_lines[idx];
+    BatchResult* result = &(*results)[idx];
+    tokens->assign(line.begin(), line.end());
+    TokenStream args{tokens->data(), tokens->data() + tokens->size()};
+    if (meta_.response_files) {
+      args.expand_response_files();
+    }
+
     ParseContext ctx{};
     ctx.out = out;
-    ctx.auto_complete = maybe_autocomplete(args);
-    return parse_args_impl(args, ctx);
-  } catch (const Exception& ex) {
-    (*out) << Exception::to_string(ex.typeno) << ": ";
-    (*out) << ex.message << "\n";
-    if (ex.typeno == Exception::BUG) {
-      (*out) << ex.stack_trace;
+    ctx.error = &result->error;
+    ctx.target = get_target(idx);
+#if ARGUE_EXCEPTIONS
+    try {
+      result->result = static_cast<ParseResult>(parse_args_impl(&args, ctx));
+    } catch (const Exception& ex) {
+      result->result = PARSE_EXCEPTION;
+      result->error.type = ex.typeno;
+      result->error.token_index = args.index();
+      result->error.message = ex.message;
+      result->error.usage = get_usage_string();
     }
-    return PARSE_EXCEPTION;
+#else
+    result->result = static_cast<ParseResult>(parse_args_impl(&args, ctx));
+#endif
+  }
+}
+
+std::vector<BatchResult> Parser::parse_batch(
+    const std::vector<std::vector<std::string>>& command_lines,
+    const std::function<ParseTarget(size_t)>& get_target,
+    size_t num_threads) const {
+  std::vector<BatchResult> results(command_lines.size());
+  if (num_threads == 0) {
+    num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  size_t num_chunks =
+      (command_lines.size() + kBatchChunkSize - 1) / kBatchChunkSize;
+  num_threads = std::min(num_threads, std::max<size_t>(1, num_chunks));
+
+  std::atomic<size_t> next_chunk{0};
+  auto worker = [&]() {
+    // NOTE(josh): each worker reuses one token buffer for all of its lines,
+    // and writes only to the results of the lines it claimed.
+    std::vector<StringPiece> tokens;
+    NullStream out{};
+    for (size_t chunk = next_chunk++; chunk < num_chunks;
+         chunk = next_chunk++) {
+      size_t begin = chunk * kBatchChunkSize;
+      size_t end = std::min(begin + kBatchChunkSize, command_lines.size());
+      parse_batch_lines(command_lines, get_target, begin, end, &tokens, &out,
+                        &results);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (size_t idx = 1; idx < num_threads; ++idx) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
   }
+  return results;
 }
 
-void Parser::validate() {
+void Parser::validate() const {
   for (auto& action : positionals_) {
     action->validate();
   }
-  for (auto& pair : short_flags_) {
-    pair.second.action->validate();
+  for (const FlagStore& store : flags_) {
+    store.action->validate();
   }
-  for (auto& pair : long_flags_) {
-    pair.second.action->validate();
+}
+
+void Parser::apply_defaults(const ParseContext& ctx) const {
+  for (auto& action : positionals_) {
+    action->apply_defaults(ctx);
+  }
+  for (const FlagStore& store : flags_) {
+    store.action->apply_defaults(ctx);
+  }
+}
+
+void Parser::apply_unused_defaults(const ParseContext& ctx,
+                                   const ParseSession& session) const {
+  for (size_t idx = session.next_positional(); idx < positionals_.size();
+       ++idx) {
+    positionals_[idx]->apply_unused_defaults(ctx);
+  }
+  for (const FlagStore& store : flags_) {
+    if (!session.is_flag_consumed(store.index)) {
+      store.action->apply_unused_defaults(ctx);
+    }
   }
 }
 
-int Parser::autocomplete(const ParseContext& ctx) {
-  std::string comp_word = ctx.arg;
+int Parser::autocomplete(const ParseContext& ctx,
+                         const ParseSession& session) const {
+  const StringPiece& comp_word = ctx.arg;
   (*ctx.auto_complete.debug) << "Completing word: " << comp_word << "\n";
   ctx.auto_complete.debug->flush();
 
@@ -309,8 +779,11 @@ int Parser::autocomplete(const ParseContext& ctx) {
     // Regardless the completion is the list of available short flags that
     // aren't already in the collection.
     (*ctx.auto_complete.debug) << "Available short flags: ";
-    for (auto& flag_pair : short_flags_m_) {
-      FlagStore store = flag_pair.second;
+    for (int32_t flag_idx : short_index_) {
+      if (flag_idx < 0 || session.is_flag_consumed(flag_idx)) {
+        continue;
+      }
+      const FlagStore& store = flags_[flag_idx];
       (*ctx.auto_complete.debug) << store.short_flag[1] << ", ";
       std::cout << store.short_flag[1] << ctx.auto_complete.ifs;
     }
@@ -322,30 +795,32 @@ int Parser::autocomplete(const ParseContext& ctx) {
 
   (*ctx.auto_complete.debug) << "Completion is anything\n";
 
-  for (auto& flag_pair : short_flags_m_) {
-    FlagStore store = flag_pair.second;
-    if (string::starts_with(store.short_flag, comp_word)) {
+  // NOTE(josh): every short flag is two characters so they can only match an
+  // empty word or a lone dash.
+  if (comp_word.empty() || comp_word == "-") {
+    for (int32_t flag_idx : short_index_) {
+      if (flag_idx < 0 || session.is_flag_consumed(flag_idx)) {
+        continue;
+      }
+      const FlagStore& store = flags_[flag_idx];
       (*ctx.auto_complete.debug) << store.short_flag << "\n";
       std::cout << store.short_flag << ctx.auto_complete.ifs;
-    } else {
-      (*ctx.auto_complete.debug)
-          << store.short_flag << " doesn't start with " << comp_word << "\n";
     }
   }
 
-  for (auto& flag_pair : long_flags_m_) {
-    FlagStore store = flag_pair.second;
-    if (string::starts_with(store.long_flag, comp_word)) {
-      (*ctx.auto_complete.debug) << store.long_flag << "\n";
-      std::cout << store.long_flag << ctx.auto_complete.ifs;
-    } else {
-      (*ctx.auto_complete.debug)
-          << store.long_flag << " doesn't start with " << comp_word << "\n";
+  auto range = prefix_range(long_index_.begin(), long_index_.end(), comp_word,
+                            long_flag_key);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    if (session.is_flag_consumed(iter->index)) {
+      continue;
     }
+    (*ctx.auto_complete.debug) << iter->name << "\n";
+    std::cout << iter->name << ctx.auto_complete.ifs;
   }
 
-  for (auto& positional : positionals_m_) {
-    positional->write_completions(ctx);
+  for (size_t idx = session.next_positional(); idx < positionals_.size();
+       ++idx) {
+    positionals_[idx]->write_completions(ctx);
   }
 
   (*ctx.auto_complete.debug).flush();
@@ -354,27 +829,147 @@ int Parser::autocomplete(const ParseContext& ctx) {
   return 0;
 }
 
-int Parser::parse_args_impl(std::list<std::string>* args,
-                            const ParseContext& parent_ctx) {
-  this->validate();
+// Return the `<count>` field of a completion spec line for `count`
+static std::string get_count_spec(int count) {
+  if (count >= 0) {
+    return std::to_string(count);
+  }
+  switch (count) {
+    case ONE_OR_MORE:
+      return "+";
+    case ZERO_OR_MORE:
+      return "*";
+    default:
+      return "!";
+  }
+}
+
+void Parser::write_completion_spec() const {
+  std::cout << "argue-completion-spec\t" << kCompletionSpecVersion << "\n";
+  size_t next_id = 1;
+  write_completion_spec(0, &next_id);
+  std::cout.flush();
+}
+
+void Parser::write_completion_spec(size_t id, size_t* next_id) const {
+  // NOTE(josh): choices are written by the same `write_completions` used for
+  // completion, as if completing an empty word, each followed by a tab.
+  NullStream null_stream{};
+  ParseContext ctx{};
+  ctx.parser = this;
+  ctx.auto_complete.ifs = "\t";
+  ctx.auto_complete.debug = &null_stream;
+
+  std::cout << "parser\t" << id << "\t" << get_command_path() << "\n";
+  for (const FlagStore& store : flags_) {
+    std::cout << "flag\t" << id << "\t" << store.index << "\t"
+              << get_count_spec(store.action->get_value_count()) << "\t"
+              << (store.short_flag.empty() ? "-" : store.short_flag) << "\t"
+              << (store.long_flag.empty() ? "-" : store.long_flag) << "\t";
+    store.action->write_completions(ctx);
+    std::cout << "\n";
+  }
+
+  std::cout << "short\t" << id;
+  for (int32_t flag_idx : short_index_) {
+    if (flag_idx >= 0) {
+      std::cout << "\t" << flag_idx;
+    }
+  }
+  std::cout << "\nlong\t" << id;
+  for (const LongFlagEntry& entry : long_index_) {
+    std::cout << "\t" << entry.index;
+  }
+  std::cout << "\n";
+
+  std::vector<std::pair<size_t, const Subparsers*>> commands;
+  for (size_t idx = 0; idx < positionals_.size(); ++idx) {
+    const ActionBase* action = positionals_[idx].get();
+    const Subparsers* subparsers = nullptr;
+    for (const auto& sub : subcommand_help_) {
+      if (sub.get() == action) {
+        subparsers = sub.get();
+      }
+    }
+    std::cout << "positional\t" << id << "\t" << idx << "\t";
+    if (subparsers) {
+      std::cout << "command";
+      commands.emplace_back(idx, subparsers);
+    } else {
+      std::cout << get_count_spec(action->get_value_count());
+    }
+    std::cout << "\t";
+    positionals_[idx]->write_completions(ctx);
+    std::cout << "\n";
+  }
+
+  // NOTE(josh): the subparsers of this parser are numbered before any of
+  // them is written, so that their ids are known for the command lines.
+  std::vector<const Parser*> children;
+  size_t child_id = *next_id;
+  for (const auto& pair : commands) {
+    for (const auto& entry : *pair.second) {
+      size_t sub_id = (*next_id)++;
+      children.push_back(entry->get_parser().get());
+      std::cout << "command\t" << id << "\t" << pair.first << "\t"
+                << entry->get_name() << "\t" << sub_id << "\n";
+      for (const std::string& alias : entry->get_aliases()) {
+        std::cout << "command\t" << id << "\t" << pair.first << "\t"
+                  << alias << "\t" << sub_id << "\n";
+      }
+    }
+  }
+
+  for (const Parser* child : children) {
+    child->write_completion_spec(child_id++, next_id);
+  }
+}
+
+int Parser::parse_args_impl(TokenStream* args,
+                            const ParseContext& parent_ctx) const {
   ParseContext ctx{parent_ctx};
   ctx.parser = this;
+  if (!frozen_) {
+    return fail_parse(
+        ctx, args->index(),
+        fmt::format("Parser '{}' was modified after it was frozen. Call "
+                    "freeze() after adding arguments and before parsing "
+                    "through a const parser.",
+                    meta_.name),
+        Exception::CONFIG_ERROR);
+  }
+  if (target_type_ && target_type_ != ctx.target.type()) {
+    return fail_parse(
+        ctx, args->index(),
+        fmt::format("Parser '{}' stores into members of a target object, "
+                    "but the parse target is missing or of a different type. "
+                    "Pass a pointer to the options struct to parse_args().",
+                    meta_.name),
+        Exception::CONFIG_ERROR);
+  }
+  // NOTE(josh): only the parsers which are actually selected by the command
+  // line get here, so defaults are not written for unused subcommands.
+  this->apply_defaults(ctx);
 
-  // Create mutable copies of each argument set so we can remove actions
-  // when they are encountered
-  positionals_m_ = positionals_;
-  short_flags_m_ = short_flags_;
-  long_flags_m_ = long_flags_;
+  // Track which actions have been consumed so that flags are not matched
+  // twice and positionals are dispatched in order.
+  ParseSession session{flags_.size(), positionals_.size()};
 
-  while (args->size() > 0) {
+  // The flag being dispatched. A token read from a response file is only
+  // valid until the token after it is popped (see `TokenStream`), but actions
+  // pop their values and may still refer to the flag, as does the loop over a
+  // cluster of short flags. The buffer is reused for every flag.
+  std::string flag;
+
+  while (!args->empty()) {
     if (ctx.auto_complete.active &&
-        ctx.auto_complete.comp_word == args->begin()) {
+        ctx.auto_complete.comp_word == args->index()) {
       ctx.arg = args->front();
       args->pop_front();
-      return autocomplete(ctx);
+      return autocomplete(ctx, session);
     }
 
-    ArgType arg_type = get_arg_type(args->front());
+    ArgType arg_type = args->front_type();
     ActionResult out{
         .keep_active = false,
         .code = PARSE_FINISHED,
@@ -382,70 +977,89 @@ int Parser::parse_args_impl(std::list<std::string>* args,
 
     switch (arg_type) {
       case SHORT_FLAG: {
-        ctx.arg = args->front();
+        size_t flag_index = args->index();
+        flag.assign(args->front().data(), args->front().size());
+        ctx.arg = flag;
         args->pop_front();
         for (size_t idx = 1; idx < ctx.arg.size(); ++idx) {
-          std::string query_flag = std::string("-") + ctx.arg[idx];
-          auto flag_iter = short_flags_m_.find(query_flag);
-          ARGUE_ASSERT(INPUT_ERROR, (flag_iter != short_flags_m_.end()))
-              << "Unrecognized short flag: " << query_flag;
-          FlagStore store = flag_iter->second;
-          ARGUE_ASSERT(BUG, static_cast<bool>(store.action))
-              << "Flag " << query_flag
+          const FlagStore* store = find_short_flag(ctx.arg[idx]);
+          if (!store || session.is_flag_consumed(store->index)) {
+            return fail_parse(
+                ctx, flag_index,
+                fmt::format("Unrecognized short flag: -{}", ctx.arg[idx]));
+          }
+          ARGUE_ASSERT(BUG, static_cast<bool>(store->action))
+              << "Flag -" << ctx.arg[idx]
               << " was found in index with empty action pointer";
-          store.action->consume_args(ctx, args, &out);
+          store->action->consume_args(ctx, args, &out);
+          if (out.code != PARSE_FINISHED) {
+            break;
+          }
 
           if (!out.keep_active) {
-            short_flags_m_.erase(store.short_flag);
-            long_flags_m_.erase(store.long_flag);
+            session.consume_flag(store->index);
           }
         }
         break;
       }
 
       case LONG_FLAG: {
-        ctx.arg = args->front();
+        size_t flag_index = args->index();
+        flag.assign(args->front().data(), args->front().size());
+        ctx.arg = flag;
         args->pop_front();
-        auto flag_iter = long_flags_m_.find(ctx.arg);
+        const FlagStore* store = find_long_flag(ctx.arg);
+        if (store && session.is_flag_consumed(store->index)) {
+          store = nullptr;
+        }
         size_t prefix_matches = 0;
-        if (flag_iter == long_flags_m_.end()) {
+        if (!store) {
           // We didn't find an exact match for this flag, so let's look for a
           // a unique prefix match. If one exists, we'll use that.
-          for (auto search_iter = long_flags_m_.begin();
-               search_iter != long_flags_m_.end(); search_iter++) {
-            if (string::starts_with(search_iter->first, ctx.arg)) {
-              flag_iter = search_iter;
-              prefix_matches++;
+          auto range = prefix_range(long_index_.begin(), long_index_.end(),
+                                    ctx.arg, long_flag_key);
+          for (auto iter = range.first; iter != range.second; ++iter) {
+            if (session.is_flag_consumed(iter->index)) {
+              continue;
             }
+            store = &flags_[iter->index];
+            prefix_matches++;
           }
         }
 
-        ARGUE_ASSERT(INPUT_ERROR, flag_iter != long_flags_m_.end())
-            << "Unrecognized long flag: " << ctx.arg;
-        ARGUE_ASSERT(INPUT_ERROR, prefix_matches < 2)
-            << "Long flag '" << ctx.arg
-            << "' is not unique as an implicit prefix of known flags";
+        if (prefix_matches > 1) {
+          return fail_parse(ctx, flag_index,
+                            fmt::format("Long flag '{}' is not unique as an "
+                                        "implicit prefix of known flags",
+                                        ctx.arg.to_string()));
+        }
+        if (!store) {
+          return fail_parse(ctx, flag_index,
+                            fmt::format("Unrecognized long flag: {}",
+                                        ctx.arg.to_string()));
+        }
 
-        FlagStore store = flag_iter->second;
-        ARGUE_ASSERT(BUG, static_cast<bool>(store.action))
+        ARGUE_ASSERT(BUG, static_cast<bool>(store->action))
             << "Flag " << ctx.arg
             << " was found in index with empty action pointer";
-        store.action->consume_args(ctx, args, &out);
+        store->action->consume_args(ctx, args, &out);
         if (!out.keep_active) {
-          short_flags_m_.erase(store.short_flag);
-          long_flags_m_.erase(store.long_flag);
+          session.consume_flag(store->index);
         }
         break;
       }
 
       case POSITIONAL: {
-        ctx.arg = "";
-        ARGUE_ASSERT(CONFIG_ERROR, positionals_m_.size() > 0)
-            << "Additional positional arguments with no available actions "
-               "remaining: '"
-            << args->front() << "'";
-        std::shared_ptr<ActionBase> action = positionals_m_.front();
-        positionals_m_.pop_front();
+        ctx.arg = StringPiece();
+        if (!session.has_positional()) {
+          return fail_parse(
+              ctx, args->index(),
+              fmt::format("Additional positional arguments with no available "
+                          "actions remaining: '{}'",
+                          args->front().to_string()));
+        }
+        const std::shared_ptr<ActionBase>& action =
+            positionals_[session.pop_positional()];
         ARGUE_ASSERT(BUG, static_cast<bool>(action))
             << "positional with empty action pointer";
         action->consume_args(ctx, args, &out);
@@ -458,242 +1072,381 @@ int Parser::parse_args_impl(std::list<std::string>* args,
     }
   }
 
-  for (const std::shared_ptr<ActionBase>& action : positionals_m_) {
-    ARGUE_ASSERT(INPUT_ERROR, !action->is_required())
-        << "Missing required positional\n"
-        << get_usage_string();
-  }
-
-  for (const auto& pair : short_flags_) {
-    const FlagStore& store = pair.second;
-    ARGUE_ASSERT(INPUT_ERROR, !store.action->is_required())
-        << "Missing required flag (" << store.short_flag << ","
-        << store.long_flag << ")" << get_usage_string();
+  for (size_t idx = session.next_positional(); idx < positionals_.size();
+       ++idx) {
+    if (positionals_[idx]->is_required()) {
+      return fail_parse(ctx, args->index(), "Missing required positional");
+    }
   }
 
-  for (const auto& pair : long_flags_) {
-    const FlagStore& store = pair.second;
-    ARGUE_ASSERT(INPUT_ERROR, !store.action->is_required())
-        << "Missing required flag (" << store.short_flag << ","
-        << store.long_flag << ")" << get_usage_string();
+  for (const FlagStore& store : flags_) {
+    if (store.action->is_required() && !session.is_flag_consumed(store.index)) {
+      return fail_parse(ctx, args->index(),
+                        fmt::format("Missing required flag ({},{})",
+                                    store.short_flag, store.long_flag));
+    }
   }
 
+  this->apply_unused_defaults(ctx, session);
   return PARSE_FINISHED;
 }
 
-void Parser::print_usage(std::ostream* out, size_t width) {
-  std::stringstream line;
-
-  std::list<std::string> parts;
+void Parser::render_usage(std::string* out) const {
   if (!meta_.command_prefix.empty()) {
-    parts.push_back(meta_.command_prefix);
+    (*out) += meta_.command_prefix;
+    (*out) += ' ';
   }
-  parts.push_back(meta_.name);
+  (*out) += meta_.name;
   for (const FlagHelp& help : flag_help_) {
-    parts.push_back(
-        get_flag_usage(help.short_flag, help.long_flag, help.action));
+    (*out) += ' ';
+    (*out) += get_flag_usage(help.short_flag, help.long_flag, help.action);
   }
 
   for (const PositionalHelp& help : positional_help_) {
-    parts.push_back(get_positional_usage(help.name, help.action));
+    (*out) += ' ';
+    (*out) += get_positional_usage(help.name, help.action);
   }
+  (*out) += '\n';
+}
 
-  (*out) << string::join(parts, " ") << "\n";
+const std::string& Parser::get_usage_buffer(std::string* scratch) const {
+  if (!frozen_) {
+    render_usage(scratch);
+    return *scratch;
+  }
+  if (!usage_ready_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(render_mutex_);
+    if (!usage_ready_.load(std::memory_order_relaxed)) {
+      usage_buffer_.clear();
+      render_usage(&usage_buffer_);
+      usage_ready_.store(true, std::memory_order_release);
+    }
+  }
+  return usage_buffer_;
 }
 
-std::string Parser::get_usage_string() {
-  std::stringstream strm{};
-  print_usage(&strm);
-  return strm.str();
+void Parser::print_usage(std::ostream* out, size_t width) const {
+  std::string scratch;
+  const std::string& usage = get_usage_buffer(&scratch);
+  out->write(usage.data(), usage.size());
 }
 
-static void print_columns(std::ostream* out, const ColumnSpec& columns,
+std::string Parser::get_usage_string() const {
+  std::string scratch;
+  return get_usage_buffer(&scratch);
+}
+
+// Append `text` to `out`, indenting every line after the first by `indent`
+// spaces. Each line is terminated by a newline, and if `text` is empty a
+// single newline is written.
+static void append_indented(std::string* out, const std::string& text,
+                            size_t indent) {
+  size_t begin = 0;
+  do {
+    size_t end = text.find('\n', begin);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    if (begin > 0) {
+      out->append(indent, ' ');
+    }
+    out->append(text, begin, end - begin);
+    (*out) += '\n';
+    begin = end + 1;
+  } while (begin < text.size());
+}
+
+// Append `count - used` spaces to `out`, if `used` is less than `count`
+static void append_padding(std::string* out, size_t count, size_t used) {
+  if (used < count) {
+    out->append(count - used, ' ');
+  }
+}
+
+static void print_columns(std::string* out, const ColumnSpec& columns,
                           const std::string& name,
                           const std::string& description) {
   size_t width = 80;
   size_t padding = (width - container_sum(columns)) / (columns.size() - 1);
+  size_t indent = columns[0] + columns[1] + 2 * padding;
 
   if (name.size() > padding + columns[0] + columns[1]) {
-    (*out) << "\n";
+    (*out) += '\n';
   }
-  (*out) << name;
-  (*out) << repeat(" ", 2 * padding + columns[0] + columns[1] - name.size());
+  (*out) += name;
+  append_padding(out, indent, name.size());
   if (name.size() > padding + columns[0] + columns[1]) {
-    (*out) << "\n";
-    (*out) << repeat(" ", columns[0] + columns[1] + 2 * padding);
-  }
-
-  std::stringstream ss(description);
-  std::string line;
-
-  if (std::getline(ss, line, '\n')) {
-    (*out) << line << "\n";
-  } else {
-    (*out) << "\n";
-  }
-
-  while (std::getline(ss, line, '\n')) {
-    (*out) << repeat(" ", columns[0] + columns[1] + 2 * padding) << line
-           << "\n";
+    (*out) += '\n';
+    out->append(indent, ' ');
   }
+  append_indented(out, description, indent);
 }
 
-void Parser::print_help(std::ostream* out, const HelpOptions& opts) {
+void Parser::print_help(std::ostream* out, const HelpOptions& opts) const {
   if (opts.format == HelpOptions::FORMAT_JSON) {
     print_helpJSON(out, opts);
-  } else {
-    print_helpText(out, opts);
+    return;
+  }
+  if (opts.format == HelpOptions::FORMAT_EXPORT) {
+    HelpOptions export_opts = opts;
+    export_opts.recurse = true;
+    print_helpJSON(out, export_opts);
+    return;
   }
 
+  print_helpText(out, opts);
   if (opts.recurse) {
     for (const auto& sub : subcommand_help_) {
-      for (auto& pair : *sub) {
-        // TODO(josh): writing the comma here is really hacky. Seems like it
-        // would be better to pass the dumper down the stack instead of the
-        // output stream. But then we need the JSON headers in the argue
-        // headers and I don't think we want that.
-        (*out) << ",";
-        pair.second->print_help(out, opts);
+      for (const auto& entry : *sub) {
+        (*out) << "\n";
+        entry->get_parser()->print_help(out, opts);
       }
     }
   }
 }
 
-void Parser::print_helpJSON(std::ostream* out, const HelpOptions& opts) {
-  // TODO(josh): Use a registry??
-  json::stream::StreamDumper dumper{out};
-  json::stream::DumpGuard object{&dumper, json::stream::GUARD_OBJECT};
-  dumper.dump_field_prefix("metadata");
-  {
-    json::stream::DumpGuard object{&dumper, json::stream::GUARD_OBJECT};
-    dumper.dump_field("id", fmt::format("{:p}", static_cast<void*>(this)));
-    dumper.dump_field("name", meta_.name);
-    dumper.dump_field("author", meta_.author);
-    dumper.dump_field("copyright", meta_.copyright);
-    dumper.dump_field("prolog", meta_.prolog);
-    dumper.dump_field("epilog", meta_.epilog);
-    dumper.dump_field("comamnd_prefix", meta_.command_prefix);
-    dumper.dump_field("subdepth", meta_.subdepth);
-    dumper.dump_field("usage", get_usage_string());
-  }
-
-  dumper.dump_field_prefix("flags");
-  {
-    json::stream::DumpGuard object{&dumper, json::stream::GUARD_LIST};
-    for (const FlagHelp& help : flag_help_) {
-      dumper.dump_event(json::stream::DumpEvent::LIST_VALUE);
-      json::stream::DumpGuard object{&dumper, json::stream::GUARD_OBJECT};
-      dumper.dump_field("short_flag", help.short_flag);
-      dumper.dump_field("long_flag", help.long_flag);
-      dumper.dump_field("help", help.action->get_help());
+namespace {
+
+// Stream buffer which collects the many small writes of a dumper into a
+// fixed size block, and passes each full block to the underlying stream with
+// a single `write()`.
+class BlockBuffer : public std::streambuf {
+ public:
+  explicit BlockBuffer(std::ostream* out) : out_(out) {
+    setp(block_, block_ + sizeof(block_));
+  }
+
+  ~BlockBuffer() {
+    sync();
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (sync() != 0) {
+      return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
     }
+    return traits_type::not_eof(c);
   }
 
-  dumper.dump_field_prefix("positional");
-  {
-    json::stream::DumpGuard object{&dumper, json::stream::GUARD_LIST};
-    for (const PositionalHelp& help : positional_help_) {
-      dumper.dump_event(json::stream::DumpEvent::LIST_VALUE);
-      json::stream::DumpGuard object{&dumper, json::stream::GUARD_OBJECT};
-      dumper.dump_field("name", help.name);
-      dumper.dump_field("help", help.action->get_help());
+  int sync() override {
+    if (pptr() > pbase()) {
+      out_->write(pbase(), pptr() - pbase());
+      setp(block_, block_ + sizeof(block_));
     }
+    return out_->good() ? 0 : -1;
   }
 
-  dumper.dump_field_prefix("subcommands");
+ private:
+  std::ostream* out_;
+  char block_[16 * 1024];
+};
+
+}  // namespace
+
+void Parser::print_helpJSON(std::ostream* out,
+                            const HelpOptions& opts) const {
+  BlockBuffer buffer{out};
+  std::ostream sink{&buffer};
   {
-    json::stream::DumpGuard object{&dumper, json::stream::GUARD_LIST};
+    json::stream::StreamDumper dumper{&sink};
+    json::stream::DumpGuard list{&dumper, json::stream::GUARD_LIST};
+    dump_helpJSON(&dumper, opts);
+  }
+  sink << "\n";
+  sink.flush();
+}
+
+void Parser::dump_helpJSON(json::stream::StreamDumper* dumper,
+                           const HelpOptions& opts) const {
+  // TODO(josh): Use a registry??
+  dumper->dump_event(json::stream::DumpEvent::LIST_VALUE);
+  {
+    json::stream::DumpGuard object{dumper, json::stream::GUARD_OBJECT};
+    dumper->dump_field_prefix("metadata");
+    {
+      json::stream::DumpGuard object{dumper, json::stream::GUARD_OBJECT};
+      dumper->dump_field("id",
+                         fmt::format("{:p}", static_cast<const void*>(this)));
+      dumper->dump_field("name", meta_.name);
+      dumper->dump_field("version", meta_.version);
+      dumper->dump_field("author", meta_.author);
+      dumper->dump_field("copyright", meta_.copyright);
+      dumper->dump_field("prolog", meta_.prolog);
+      dumper->dump_field("epilog", meta_.epilog);
+      dumper->dump_field("comamnd_prefix", meta_.command_prefix);
+      dumper->dump_field("subdepth", meta_.subdepth);
+      std::string scratch;
+      dumper->dump_field("usage", get_usage_buffer(&scratch));
+    }
+
+    dumper->dump_field_prefix("flags");
+    {
+      json::stream::DumpGuard object{dumper, json::stream::GUARD_LIST};
+      for (const FlagHelp& help : flag_help_) {
+        dumper->dump_event(json::stream::DumpEvent::LIST_VALUE);
+        json::stream::DumpGuard object{dumper, json::stream::GUARD_OBJECT};
+        dumper->dump_field("short_flag", help.short_flag);
+        dumper->dump_field("long_flag", help.long_flag);
+        dumper->dump_field("help", help.action->get_help());
+      }
+    }
+
+    dumper->dump_field_prefix("positional");
+    {
+      json::stream::DumpGuard object{dumper, json::stream::GUARD_LIST};
+      for (const PositionalHelp& help : positional_help_) {
+        dumper->dump_event(json::stream::DumpEvent::LIST_VALUE);
+        json::stream::DumpGuard object{dumper, json::stream::GUARD_OBJECT};
+        dumper->dump_field("name", help.name);
+        dumper->dump_field("help", help.action->get_help());
+      }
+    }
+
+    dumper->dump_field_prefix("subcommands");
+    {
+      json::stream::DumpGuard object{dumper, json::stream::GUARD_LIST};
+      for (const auto& sub : subcommand_help_) {
+        for (const auto& entry : *sub) {
+          dumper->dump_event(json::stream::DumpEvent::LIST_VALUE);
+          json::stream::DumpGuard object{dumper, json::stream::GUARD_OBJECT};
+          // NOTE(josh): the id links to the recursive dump of the subparser,
+          // which only exists if the subparser is built.
+          if (opts.recurse || entry->is_built()) {
+            const void* id = entry->get_parser().get();
+            dumper->dump_field("id", fmt::format("{:p}", id));
+          }
+          dumper->dump_field("name", entry->get_name());
+          dumper->dump_field("help", entry->get_prolog());
+        }
+      }
+    }
+
+    if (opts.format == HelpOptions::FORMAT_EXPORT) {
+      // NOTE(josh): always rendered, the export is what produces the
+      // precomputed help so it must not read it back
+      std::string text;
+      render_help_text({opts.columns, 0}, &text);
+      dumper->dump_field("help_text", text);
+    }
+  }
+
+  if (opts.recurse) {
     for (const auto& sub : subcommand_help_) {
-      for (auto& pair : *sub) {
-        dumper.dump_event(json::stream::DumpEvent::LIST_VALUE);
-        json::stream::DumpGuard object{&dumper, json::stream::GUARD_OBJECT};
-        dumper.dump_field(
-            "id", fmt::format("{:p}", static_cast<void*>(pair.second.get())));
-        dumper.dump_field("name", pair.first);
-        dumper.dump_field("help", pair.second->get_prolog());
+      for (const auto& entry : *sub) {
+        entry->get_parser()->dump_helpJSON(dumper, opts);
       }
     }
   }
 }
 
-void Parser::print_helpText(std::ostream* out, const HelpOptions& opts) {
+const std::string& Parser::get_help_buffer(const HelpOptions& opts,
+                                           std::string* scratch) const {
+  if (frozen_) {
+    if (!help_ready_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(render_mutex_);
+      if (!help_ready_.load(std::memory_order_relaxed)) {
+        help_buffer_.clear();
+        const PrecomputedHelp* precomputed = nullptr;
+        if (opts.columns == kDefaultColumns && opts.depth == 0) {
+          precomputed = find_help_text(get_command_path());
+        }
+        if (precomputed) {
+          help_buffer_.assign(precomputed->text, precomputed->size);
+        } else {
+          render_help_text(opts, &help_buffer_);
+        }
+        help_columns_ = opts.columns;
+        help_depth_ = opts.depth;
+        help_ready_.store(true, std::memory_order_release);
+        return help_buffer_;
+      }
+    }
+    if (help_columns_ == opts.columns && help_depth_ == opts.depth) {
+      return help_buffer_;
+    }
+  }
+  render_help_text(opts, scratch);
+  return *scratch;
+}
+
+void Parser::print_helpText(std::ostream* out,
+                            const HelpOptions& opts) const {
+  std::string scratch;
+  const std::string& help = get_help_buffer(opts, &scratch);
+  out->write(help.data(), help.size());
+}
+
+void Parser::render_help_text(const HelpOptions& opts,
+                              std::string* out) const {
   const ColumnSpec columns = opts.columns;
   size_t width = 80;
   size_t padding = (width - container_sum(columns)) / (columns.size() - 1);
+  size_t indent = columns[0] + columns[1] + 2 * padding;
 
   // TODO(josh): detect multiline and break it up
   if (meta_.subdepth < 1) {
-    (*out) << repeat("=", meta_.name.size()) << "\n"
-           << meta_.name << "\n"
-           << repeat("=", meta_.name.size()) << "\n";
+    out->append(meta_.name.size(), '=');
+    (*out) += '\n';
+    (*out) += meta_.name;
+    (*out) += '\n';
+    out->append(meta_.name.size(), '=');
+    (*out) += '\n';
 
     if (!meta_.version.empty()) {
-      (*out) << "version: " << meta_.version << "\n";
+      (*out) += "version: " + meta_.version + "\n";
     }
-    if (!meta_.author.empty() > 0) {
-      (*out) << "author : " << meta_.author << "\n";
+    if (!meta_.author.empty()) {
+      (*out) += "author : " + meta_.author + "\n";
     }
-    if (!meta_.copyright.empty() > 0) {
-      (*out) << "copyright: " << meta_.copyright << "\n";
+    if (!meta_.copyright.empty()) {
+      (*out) += "copyright: " + meta_.copyright + "\n";
     }
-    (*out) << "\n";
+    (*out) += '\n';
   }
 
-  print_usage(out, width);
+  // NOTE(josh): not `get_usage_buffer()`, the caller may hold render_mutex_
+  render_usage(out);
 
   if (meta_.prolog.size() > 0) {
-    (*out) << "\n" << meta_.prolog << "\n";
+    (*out) += "\n" + meta_.prolog + "\n";
   }
 
   if (flag_help_.size() > 0) {
     if (opts.depth < 1) {
-      (*out) << "\n";
-      (*out) << "Flags:\n";
-      (*out) << repeat("-", 6) << "\n";
+      (*out) += "\nFlags:\n------\n";
     } else {
-      (*out) << repeat("-", 4) << "\n";
+      (*out) += "----\n";
     }
     for (const FlagHelp& help : flag_help_) {
       // If we're going to overflow our column, then also push a newline
       // between us and the previous one for some additional padding
       if (help.long_flag.size() > columns[1]) {
-        (*out) << "\n";
+        (*out) += '\n';
       }
-      (*out) << help.short_flag;
-      (*out) << repeat(" ", padding + columns[0] - help.short_flag.size());
-      (*out) << help.long_flag;
-      (*out) << repeat(" ", padding + columns[1] - help.long_flag.size());
+      (*out) += help.short_flag;
+      append_padding(out, padding + columns[0], help.short_flag.size());
+      (*out) += help.long_flag;
+      append_padding(out, padding + columns[1], help.long_flag.size());
 
       // If we overflowed the column, then add a new line so that we can
       // start the help text at the right column
       if (help.long_flag.size() > columns[1]) {
-        (*out) << "\n";
-        (*out) << repeat(" ", columns[0] + columns[1] + 2 * padding);
-      }
-
-      std::stringstream ss(help.action->get_help(columns[2]));
-      std::string line;
-
-      if (std::getline(ss, line, '\n')) {
-        (*out) << line << "\n";
-      } else {
-        (*out) << "\n";
-      }
-
-      while (std::getline(ss, line, '\n')) {
-        (*out) << repeat(" ", columns[0] + columns[1] + 2 * padding) << line
-               << "\n";
+        (*out) += '\n';
+        out->append(indent, ' ');
       }
+      append_indented(out, help.action->get_help(columns[2]), indent);
     }
   }
 
   if (positional_help_.size() > 0) {
     if (opts.depth < 1) {
-      (*out) << "\n";
-      (*out) << "Positionals:\n";
-      (*out) << repeat("-", 12) << "\n";
+      (*out) += "\nPositionals:\n------------\n";
     } else {
-      (*out) << repeat("-", 4) << "\n";
+      (*out) += "----\n";
     }
     for (const PositionalHelp& help : positional_help_) {
       print_columns(out, columns, help.name, help.action->get_help(columns[2]));
@@ -701,22 +1454,25 @@ void Parser::print_helpText(std::ostream* out, const HelpOptions& opts) {
   }
 
   if (opts.depth < 1 && subcommand_help_.size() > 0) {
-    (*out) << "\n";
-    (*out) << "Subcommands:\n" << repeat("-", 12) << "\n";
+    (*out) += "\nSubcommands:\n------------\n";
     for (const auto& sub : subcommand_help_) {
-      for (auto& pair : *sub) {
-        print_columns(out, columns, pair.first,
-                      pair.second->get_prolog(columns[2]));
+      for (const auto& entry : *sub) {
+        std::string name = entry->get_name();
+        if (!entry->get_aliases().empty()) {
+          name += " (" + string::join(entry->get_aliases(), ", ") + ")";
+        }
+        print_columns(out, columns, name, entry->get_prolog(columns[2]));
       }
     }
   }
 
   if (meta_.epilog.size() > 0) {
-    (*out) << meta_.epilog;
+    (*out) += meta_.epilog;
   }
 }
 
-void Parser::print_version(std::ostream* out, const ColumnSpec& columns) {
+void Parser::print_version(std::ostream* out,
+                           const ColumnSpec& columns) const {
   // TODO(josh): detect multiline and break it up
   (*out) << meta_.name << " ";
   if (meta_.version.size() > 0) {
@@ -724,10 +1480,33 @@ void Parser::print_version(std::ostream* out, const ColumnSpec& columns) {
   }
 }
 
-std::string Parser::get_prolog(size_t column_width) {
+std::string Parser::get_command_path() const {
+  std::string path = meta_.command_prefix + " " + meta_.name;
+  size_t begin = path.find_first_not_of(' ');
+  if (begin == std::string::npos) {
+    return "";
+  }
+  return path.substr(begin);
+}
+
+std::string Parser::get_prolog(size_t column_width) const {
   return wrap(meta_.prolog, column_width);
 }
 
+#if ARGUE_HAVE_ELF_NOTES
+// NOTE(josh): argue-can-complete finds this note through the program headers
+// in O(sections), even in stripped programs. `ARGUE_AUTOCOMPLETE_ME` below is
+// only needed to detect programs linked against older versions of argue.
+static_assert(sizeof(kCompletionSpecVersion) == 2,
+              "kCapabilityNote is sized for a single character version");
+ARGUE_ELF_NOTE static const ElfNote<sizeof(kCompletionSpecVersion)>
+    kCapabilityNote = {sizeof(kElfNoteName),
+                       sizeof(kCompletionSpecVersion),
+                       NOTE_CAPABILITY,
+                       "argue",
+                       {kCompletionSpecVersion[0], kCompletionSpecVersion[1]}};
+#endif
+
 }  // namespace argue
 
 extern "C" {
@@ -1,18 +1,31 @@
 #pragma once
 // Copyright 2018-2020 Josh Bialkowski <josh.bialkowski@gmail.com>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "argue/action.h"
 #include "argue/keywords.h"
 #include "argue/kwargs.h"
+#include "argue/token_stream.h"
 #include "argue/util.h"
 
+// NOTE(josh): the JSON headers are only needed to implement the help printer
+namespace json {
+namespace stream {
+class StreamDumper;
+}  // namespace stream
+}  // namespace json
+
 namespace argue {
 
 // =============================================================================
@@ -49,13 +62,46 @@ std::string get_flag_usage(const std::string& short_flag,
 std::string get_positional_usage(const std::string& name,
                                  const std::shared_ptr<ActionBase>& options);
 
-// Value type for flag maps, allows us to reverse loop up in each list.
+// Value type for the flag table, allows us to reverse loop up in each list.
 struct FlagStore {
   std::string short_flag;  //< The short flag for this action, if it exists
   std::string long_flag;   //< The long flag for this action, if it exists
   std::shared_ptr<ActionBase> action;  //< the action associated with the flag
+  size_t index;  //< index of this flag in registration order, used to track
+                 //  whether or not it has been consumed during a parse
+};
+
+// Entry in the sorted long flag index of a frozen parser
+struct LongFlagEntry {
+  StringPiece name;  //< the long flag, referencing the storage of the
+                     //  corresponding `FlagStore`
+  size_t index;      //< index of the `FlagStore` in the flag table
+};
+
+// Outcome of parsing one command line of a batch, see `Parser::parse_batch`
+struct BatchResult {
+  ParseResult result;  //< result of `try_parse_args` for this command line
+  ParseError error;    //< filled if `result` is PARSE_EXCEPTION
+};
+
+// Text help of one parser of a program, rendered ahead of time. See
+// `register_help_text()`.
+struct PrecomputedHelp {
+  const char* command;  //< command path of the parser, e.g. "prog sub"
+  const char* text;     //< the text help of that parser
+  size_t size;          //< length of `text`
 };
 
+// Register a table of text help rendered ahead of time.
+/* The table is usually the source generated by the `argue_help_artifacts()`
+ * cmake helper, compiled into the program. When a frozen parser first prints
+ * text help with the default options, it uses the entry whose `command`
+ * matches its own command path instead of rendering the help. The table must
+ * outlive every parser, and a later registration replaces an earlier one.
+ * Always returns true, so that the call can initialize a static. */
+bool register_help_text(const PrecomputedHelp* begin,
+                        const PrecomputedHelp* end);
+
 // Helper to convert version tuple to a string
 class VersionString : public std::string {
  public:
@@ -64,13 +110,59 @@ class VersionString : public std::string {
                 int increment);
 };
 
+// =============================================================================
+//                              Parse Session
+// =============================================================================
+
+// Mutable state of a single parse through a single parser.
+/* A `Parser` is not modified while it parses, so one parser definition may be
+ * shared by any number of threads parsing concurrently. Everything that
+ * changes during a parse lives in a session, which `parse_args_impl` creates on
+ * its stack. Flags are identified by their registration index and a consumed
+ * flag is marked with a single bit. Positionals are consumed in order so they
+ * only need a cursor. */
+class ParseSession {
+ public:
+  ParseSession(size_t num_flags, size_t num_positionals);
+  ParseSession(const ParseSession&) = delete;
+  ParseSession& operator=(const ParseSession&) = delete;
+
+  // Return true if the flag with the given index has been consumed
+  bool is_flag_consumed(size_t flag_idx) const;
+
+  // Mark the flag with the given index as consumed
+  void consume_flag(size_t flag_idx);
+
+  // Return true if there are positional actions remaining
+  bool has_positional() const;
+
+  // Return the index of the next positional action and advance past it
+  size_t pop_positional();
+
+  // Return the index of the next positional action
+  size_t next_positional() const;
+
+ private:
+  // Sessions for parsers with no more than this many flags do not allocate
+  static const size_t kInlineWords = 2;
+
+  uint64_t inline_words_[kInlineWords];
+  std::vector<uint64_t> heap_words_;
+  uint64_t* words_;  //< points to either inline_words_ or heap_words_
+
+  size_t next_positional_;
+  size_t num_positionals_;
+};
+
 // =============================================================================
 //                                 Parser
 // =============================================================================
 
 // Main class for parsing command line arguments.
 /* Use `add_argument` to add actions (flags, positionals) to the parser, then
- * call `parse_args`. */
+ * call `parse_args`. Parsing does not modify the parser so, once it is fully
+ * configured and frozen (see `freeze()`), a parser may be used to parse from
+ * multiple threads at once. */
 class Parser {
  public:
   // Collection of program metadata, used to initialize a parser.
@@ -86,6 +178,8 @@ class Parser {
     std::string command_prefix;  //< used to forward down to subparsers
     size_t subdepth;             //< number of parsers between this one and the
                                  //  main one
+    bool response_files;         //< if true, an argument `@path` is replaced
+                                 //  by the arguments in the file at `path`
   };
 
   // Construct a new parser.
@@ -119,6 +213,21 @@ class Parser {
       const std::string& short_flag, const std::string& long_flag, T* dest,
       KWargs<typename ElementType<T>::value> spec = {});
 
+  // Add a flag argument storing into a member of the parse target
+  /* As above, <T> is inferred from the type of the member. The member is
+     resolved against the target object supplied to each parse call, see
+     `ParseTarget`. */
+  template <class Class, class Field>
+  KWargs<typename ElementType<Field>::value> add_argument(
+      const std::string& short_flag, const std::string& long_flag,
+      Field Class::*dest, KWargs<typename ElementType<Field>::value> spec = {});
+
+  template <class Class, class Field>
+  KWargs<typename ElementType<Field>::value> add_argument(
+      const std::string& short_flag, const std::string& long_flag,
+      const MemberPath<Class, Field>& dest,
+      KWargs<typename ElementType<Field>::value> spec = {});
+
   // Add a positional argument or a flag argument that has either a short flag
   // or a long flag but not both.
   template <typename T = void>
@@ -133,6 +242,18 @@ class Parser {
       const std::string& name_or_flag, T* dest,
       KWargs<typename ElementType<T>::value> spec = {});
 
+  // Add a flag or positional argument storing into a member of the parse
+  // target. <T> is inferred from the type of the member.
+  template <class Class, class Field>
+  KWargs<typename ElementType<Field>::value> add_argument(
+      const std::string& name_or_flag, Field Class::*dest,
+      KWargs<typename ElementType<Field>::value> spec = {});
+
+  template <class Class, class Field>
+  KWargs<typename ElementType<Field>::value> add_argument(
+      const std::string& name_or_flag, const MemberPath<Class, Field>& dest,
+      KWargs<typename ElementType<Field>::value> spec = {});
+
   // Add a flag argument with the given short and long flag names using the
   // keywords API.
   template <TagNo TAG, class T, class... Args>
@@ -151,31 +272,168 @@ class Parser {
                                              std::string* dest,
                                              const SubparserOptions& opts = {});
 
+  // Create the subparser action, storing the command name into a member of
+  // the parse target.
+  template <class Class>
+  std::shared_ptr<Subparsers> add_subparsers(const std::string& name,
+                                             std::string Class::*dest,
+                                             const SubparserOptions& opts = {});
+
+  template <class Class>
+  std::shared_ptr<Subparsers> add_subparsers(
+      const std::string& name, const MemberPath<Class, std::string>& dest,
+      const SubparserOptions& opts = {});
+
+  // Validate the configuration and compile the registered flags into the
+  // lookup tables used while parsing.
+  /* Validation is only done once, the result is cached until the parser is
+   * modified again. The short flags are indexed by a direct table of 128
+   * entries, one for each ASCII character, and the long flags by a sorted flat
+   * array. Lookups in either table do not allocate. This is done implicitly
+   * by any call to `parse_args` on a non-const parser. It must be done
+   * explicitly before parsing through a const reference (e.g. from multiple
+   * threads).
+   *
+   * Freezing a parser also freezes all of its subparsers. Adding an argument
+   * to a parser thaws it. It is a CONFIG_ERROR for the member destinations of
+   * one parser to belong to different classes. */
+  void freeze();
+
+  // Return true if the lookup tables are up to date with the registered
+  // flags. Note that this does not check subparsers.
+  bool is_frozen() const;
+
   // Parse command line out of a standard string vector, as expected in
   // `int main(int argc, char** argv)`.
+  /* If the parser was constructed without a name, this will assign the name
+   * from `argv[0]` */
   int parse_args(int argc, char** argv, std::ostream* log = &std::cerr);
 
+  // Parse command line out of a standard string vector, as expected in
+  // `int main(int argc, char** argv)`. `argv[0]` is ignored.
+  int parse_args(int argc, char** argv, std::ostream* log = &std::cerr) const;
+
   // Parse command line out of a list of strings. This is useful mostly for
   // testing/verification.
   int parse_args(const std::initializer_list<std::string>& init_list,
                  std::ostream* log = &std::cerr);
+  int parse_args(const std::initializer_list<std::string>& init_list,
+                 std::ostream* log = &std::cerr) const;
 
   // Parse command line arguments out of a list of string. Arguments are
   // removed from the list, modifying it as the parser works through it's
   // state machine.
   int parse_args(std::list<std::string>* args, std::ostream* log = &std::cerr);
+  int parse_args(std::list<std::string>* args,
+                 std::ostream* log = &std::cerr) const;
+
+  // Parse command line arguments out of a stream of tokens. The stream is
+  // advanced past each argument as it is consumed. The token storage must
+  // outlive the call.
+  int parse_args(TokenStream* args, std::ostream* log = &std::cerr);
+  int parse_args(TokenStream* args, std::ostream* log = &std::cerr) const;
+
+  // Parse the command line into the members of `target`.
+  /* These are the same as the overloads above, except that any destination
+   * declared as a member pointer (e.g. `&Options::threads`) is stored into
+   * `target`. The parser itself is not modified by the parse, so one frozen
+   * parser can fill any number of option structs. If the parser has member
+   * destinations then `target` must point to an object of that class,
+   * otherwise the parse fails with a CONFIG_ERROR. */
+  int parse_args(const ParseTarget& target, int argc, char** argv,
+                 std::ostream* log = &std::cerr);
+  int parse_args(const ParseTarget& target, int argc, char** argv,
+                 std::ostream* log = &std::cerr) const;
+  int parse_args(const ParseTarget& target,
+                 const std::initializer_list<std::string>& init_list,
+                 std::ostream* log = &std::cerr);
+  int parse_args(const ParseTarget& target,
+                 const std::initializer_list<std::string>& init_list,
+                 std::ostream* log = &std::cerr) const;
+  int parse_args(const ParseTarget& target, TokenStream* args,
+                 std::ostream* log = &std::cerr);
+  int parse_args(const ParseTarget& target, TokenStream* args,
+                 std::ostream* log = &std::cerr) const;
+
+  // Parse the command line without throwing on invalid input.
+  /* Returns PARSE_FINISHED, or PARSE_ABORTED if an action (e.g. `--help`)
+   * terminated the parse early. If the command line is invalid, returns
+   * PARSE_EXCEPTION and fills `error` with the type of error, the index of
+   * the offending argument, a message, and the usage of the (sub)parser which
+   * rejected it. Nothing is written to `out` except the output of actions
+   * like `--help`.
+   *
+   * Input errors are never thrown, by any action or subparser, so this is
+   * usable when exceptions are disabled and it does not unwind on bad input.
+   * The parser must be frozen; if it is not, that is reported as a
+   * CONFIG_ERROR. As for `argc`/`argv` in `parse_args`, `argv[0]` is
+   * ignored and is not counted by `ParseError::token_index`. */
+  ParseResult try_parse_args(int argc, char** argv, ParseError* error,
+                             std::ostream* out = &std::cout) const;
+  ParseResult try_parse_args(
+      const std::initializer_list<std::string>& init_list, ParseError* error,
+      std::ostream* out = &std::cout) const;
+  ParseResult try_parse_args(TokenStream* args, ParseError* error,
+                             std::ostream* out = &std::cout) const;
+
+  // Parse the command line into the members of `target` without throwing on
+  // invalid input. See the `parse_args` overloads which take a target.
+  ParseResult try_parse_args(const ParseTarget& target, int argc, char** argv,
+                             ParseError* error,
+                             std::ostream* out = &std::cout) const;
+  ParseResult try_parse_args(
+      const ParseTarget& target,
+      const std::initializer_list<std::string>& init_list, ParseError* error,
+      std::ostream* out = &std::cout) const;
+  ParseResult try_parse_args(const ParseTarget& target, TokenStream* args,
+                             ParseError* error,
+                             std::ostream* out = &std::cout) const;
+
+  // Parse many command lines with this parser, in parallel.
+  /* Each element of `command_lines` is the list of arguments of one command
+   * line (not including the program name). Command line `i` is parsed into
+   * `get_target(i)` and its outcome is stored at index `i` of the returned
+   * vector. Lines are handed out to `num_threads` workers (including the
+   * calling thread) in small chunks, so a slow line does not hold up the
+   * rest. If `num_threads` is zero, one worker is used per hardware thread.
+   *
+   * The parser must be frozen and its destinations must be members of the
+   * target (fixed pointer destinations would be shared by all workers).
+   * Completion is disabled and the output of actions like `--help` is
+   * discarded. Configuration errors and bugs are reported for the line on
+   * which they occurred rather than thrown. */
+  std::vector<BatchResult> parse_batch(
+      const std::vector<std::vector<std::string>>& command_lines,
+      const std::function<ParseTarget(size_t)>& get_target,
+      size_t num_threads = 0) const;
+
+  // Parse many command lines in parallel, one into each element of `targets`.
+  /* `targets` is resized to the number of command lines, and each of its
+   * elements is reset to a default constructed `Options` before the parse.
+   * See the overload above. */
+  template <class Options>
+  std::vector<BatchResult> parse_batch(
+      const std::vector<std::vector<std::string>>& command_lines,
+      std::vector<Options>* targets, size_t num_threads = 0) const;
 
   // Print the formatted usage string: the short specification usally printed
   // on command line error or at the top of the help output. This is the the
   // description of generally how to formulate a command call.
-  void print_usage(std::ostream* out, size_t width = 80);
+  /* Once the parser is frozen the usage is rendered only once, into a buffer
+   * which is kept until the parser is next modified, and each call writes
+   * that buffer with a single `write()`. */
+  void print_usage(std::ostream* out, size_t width = 80) const;
 
   // Return the formatted usage with default width as a string.
-  std::string get_usage_string();
+  std::string get_usage_string() const;
 
   // Collection of options for help printing
   struct HelpOptions {
-    enum FormatNo { FORMAT_TEXT = 0, FORMAT_JSON };
+    // FORMAT_EXPORT is FORMAT_JSON for the whole tree (`recurse` is
+    // implied), where the object of each parser also has the rendered text
+    // help as `help_text`. It is the input of the `argue_help_artifacts()`
+    // cmake helper.
+    enum FormatNo { FORMAT_TEXT = 0, FORMAT_JSON, FORMAT_EXPORT };
 
     ColumnSpec columns;  //< specify output colums
     int depth;           //< depth of the print, for recursive cases
@@ -187,50 +445,166 @@ class Parser {
   // This is the detailed description usually presented with `-h` or `--help`
   // that lists out all the command line options along with a sentence or
   // paragraph about what the option does.
+  /* As for `print_usage`, text help of a frozen parser is rendered once and
+   * then written from the buffer.
+   *
+   * In `FORMAT_JSON` the output is a complete JSON document: a list with one
+   * object per parser. With `recurse` the list includes every subparser of
+   * the tree. The whole tree is written by one streaming dumper through a
+   * block buffer, so the output stream sees a few large writes. */
   void print_help(std::ostream* out,
-                  const HelpOptions& opts = {kDefaultColumns, 0});
+                  const HelpOptions& opts = {kDefaultColumns, 0}) const;
 
   // Print the version string to the given stream;
   void print_version(std::ostream* out,
-                     const ColumnSpec& columns = kDefaultColumns);
-
-  // Backend for parse_args above. The only difference between the two is that//
-  // parse_args() will swallow any exceptions thrown during parsing while this
-  // function will allow them past.
-  int parse_args_impl(std::list<std::string>* args,
-                      const ParseContext& parent_ctx);
-
-  // Match the current argument against the set of available flags or
-  // positional arguments and output possible completions.
-  int autocomplete(const ParseContext& parent_ctx);
+                     const ColumnSpec& columns = kDefaultColumns) const;
+
+  // Backend for parse_args above. Parses arguments out of `args` in the context
+  // of a parent parser (if this is a subparser). Invalid input is reported
+  // through `ctx.error`, see `fail_parse`. Unlike parse_args(), this function
+  // does not catch exceptions due to configuration errors or bugs.
+  int parse_args_impl(TokenStream* args, const ParseContext& parent_ctx) const;
+
+  // Match the current argument against the set of flags or positional
+  // arguments which have not been consumed by `session` and output possible
+  // completions.
+  int autocomplete(const ParseContext& parent_ctx,
+                   const ParseSession& session) const;
+
+  // Write the completion spec of this parser and all of its subparsers to
+  // `std::cout`. This is what the program writes, instead of parsing, when it
+  // is executed with `_ARGUECOMPLETE=spec`.
+  /* The spec is everything `autocomplete` needs to know about the tree: the
+   * flags, positionals, subcommands, choices and the number of values each
+   * consumes. The bash completion script caches it so that completion does
+   * not have to execute the program for every <tab>. Lazy subparsers are
+   * constructed.
+   *
+   * The spec is line based and tab separated. The first line is
+   * `argue-completion-spec 1`, and each parser in the tree is identified by an
+   * integer id, zero for this parser:
+   *
+   *     parser <id> <command path>
+   *     flag <id> <flag idx> <count> <short flag|-> <long flag|-> <choices...>
+   *     short <id> <flag idx...>   (in the order they are completed)
+   *     long <id> <flag idx...>    (in the order they are completed)
+   *     positional <id> <idx> <count|command> <choices...>
+   *     command <id> <positional idx> <name or alias> <subparser id>
+   *
+   * where `<count>` is the number of values consumed, `+`, `*`, or `!` if the
+   * values consumed can only be known by executing the action (see
+   * `ActionBase::get_value_count`). The choices are the completions of an
+   * empty word. */
+  void write_completion_spec() const;
+
+  // Return the full command of this parser, e.g. "prog sub" for the
+  // subcommand "sub" of "prog". This is the key of its `PrecomputedHelp`.
+  std::string get_command_path() const;
 
   // Return the proglog for the parser help. Primarily used by subcommands for
   // subcommand indexing.
-  std::string get_prolog(size_t column_width = 0);
+  std::string get_prolog(size_t column_width = 0) const;
 
   // Calls action->validate() for all positional and flag actions registered
-  // to the parser.
-  void validate();
+  // to the parser. This is done by `freeze()` so it does not usually need to
+  // be called directly.
+  void validate() const;
+
+  // Calls action->apply_defaults() for all positional and flag actions
+  // registered to the parser. This is done at the start of each parse through
+  // this parser.
+  void apply_defaults(const ParseContext& ctx) const;
+
+  // Calls action->apply_unused_defaults() for the actions which were not
+  // consumed during `session`. This is done at the end of each successful
+  // parse through this parser.
+  void apply_unused_defaults(const ParseContext& ctx,
+                             const ParseSession& session) const;
 
  private:
-  void print_helpText(std::ostream* out, const HelpOptions& opts);
-  void print_helpJSON(std::ostream* out, const HelpOptions& opts);
+  void print_helpText(std::ostream* out, const HelpOptions& opts) const;
+  void print_helpJSON(std::ostream* out, const HelpOptions& opts) const;
+
+  // Dump the help of this parser as the next element of the list of parsers
+  // being written by `dumper`. If `opts.recurse` then the help of each
+  // subparser follows it, so the whole tree is one list in a single pass.
+  void dump_helpJSON(json::stream::StreamDumper* dumper,
+                     const HelpOptions& opts) const;
+
+  // Write the spec lines of this parser with the given `id`, then those of
+  // its subparsers, which are numbered from `*next_id`.
+  void write_completion_spec(size_t id, size_t* next_id) const;
+
+  // Append the usage string to `out`, see `print_usage`
+  void render_usage(std::string* out) const;
+
+  // Append the text help to `out`, see `print_help`
+  void render_help_text(const HelpOptions& opts, std::string* out) const;
+
+  // Return the rendered usage. If the parser is frozen this is the cached
+  // rendering (built by the first call), otherwise it is rendered into
+  // `scratch`.
+  const std::string& get_usage_buffer(std::string* scratch) const;
+
+  // Return the rendered text help, as for `get_usage_buffer`. Only the help
+  // for the options of the first call is cached, help for any other options
+  // is rendered into `scratch`.
+  const std::string& get_help_buffer(const HelpOptions& opts,
+                                     std::string* scratch) const;
+
+  // Freeze the parser ahead of a parse, reporting any configuration error to
+  // `out` in the same way as errors during the parse. Returns false on error.
+  bool freeze_for_parse(std::ostream* out);
+
+  // Parse the command lines in `[begin, end)` of a batch, see `parse_batch`
+  void parse_batch_lines(
+      const std::vector<std::vector<std::string>>& command_lines,
+      const std::function<ParseTarget(size_t)>& get_target, size_t begin,
+      size_t end, std::vector<StringPiece>* tokens, std::ostream* out,
+      std::vector<BatchResult>* results) const;
+
+  // Return the flag registered for the short flag `-{c}`, or nullptr if there
+  // is no such flag. The parser must be frozen.
+  const FlagStore* find_short_flag(char c) const;
+
+  // Return the flag registered with exactly the long flag `flag`, or nullptr
+  // if there is no such flag. The parser must be frozen.
+  const FlagStore* find_long_flag(const StringPiece& flag) const;
+
+  // Record the target type of `action`'s member destination, if it has one,
+  // asserting that it agrees with those already recorded. Used by `freeze()`.
+  void merge_target_type(const ActionBase* action);
 
   Metadata meta_;
 
-  // Mapping of short flag strings (i.e. `-h` or `-v`) to the action associated
-  // with them.
-  std::map<std::string, FlagStore> short_flags_;
-  std::map<std::string, FlagStore> short_flags_m_;  // mutable version
+  // Table of all flag actions, in the order in which they were registered
+  std::vector<FlagStore> flags_;
+
+  // Mapping of short flag strings (i.e. `-h` or `-v`) to the index of the
+  // flag in `flags_`. Used during registration.
+  std::map<std::string, size_t> short_flags_;
 
-  // Mapping of long flag strings (i.e. `--help` or `--version`) to the action
-  // associated with them.
-  std::map<std::string, FlagStore> long_flags_;
-  std::map<std::string, FlagStore> long_flags_m_;  // mutable version
+  // Mapping of long flag strings (i.e. `--help` or `--version`) to the index
+  // of the flag in `flags_`. Used during registration.
+  std::map<std::string, size_t> long_flags_;
 
-  // List of actions associated with positional arguments.
-  std::list<std::shared_ptr<ActionBase>> positionals_;
-  std::list<std::shared_ptr<ActionBase>> positionals_m_;  // mutable version
+  // True if the lookup tables below are up to date with `flags_`
+  bool frozen_;
+
+  // Direct-indexed table mapping the character of an ASCII short flag to the
+  // index of that flag in `flags_`, or -1 if there is no such flag.
+  std::array<int32_t, 128> short_index_;
+
+  // Long flags, sorted lexicographically, with their index in `flags_`
+  std::vector<LongFlagEntry> long_index_;
+
+  // The `type_id` of the class whose members are destinations of this
+  // parser's actions, or empty if there are none. Computed by `freeze()`.
+  TypeId target_type_;
+
+  // Actions associated with positional arguments, in the order in which they
+  // consume arguments.
+  std::vector<std::shared_ptr<ActionBase>> positionals_;
 
   // A list of flag help specifications, in the order which the flags were
   // registered with the parser. This list is what is used by the printer
@@ -244,6 +618,18 @@ class Parser {
 
   // A list of subcommand help parsers so that we an recurse on sub commands
   std::list<std::shared_ptr<Subparsers>> subcommand_help_;
+
+  // Renderings of the usage and text help, cached while the parser is frozen
+  // so that they are not rebuilt for every error or `--help`. They are built
+  // on first use under `render_mutex_` and discarded by `freeze()` whenever
+  // the parser was modified since it was last frozen.
+  mutable std::mutex render_mutex_;
+  mutable std::atomic<bool> usage_ready_;
+  mutable std::string usage_buffer_;
+  mutable std::atomic<bool> help_ready_;
+  mutable std::string help_buffer_;
+  mutable ColumnSpec help_columns_;  //< columns of `help_buffer_`
+  mutable int help_depth_;           //< depth of `help_buffer_`
 };
 
 }  // namespace argue
@@ -15,22 +15,38 @@ void Parser::add_action(const std::string& short_flag,
       << "Cannot add_argument with both short_flag='' and long_flag=''";
   action->set_usage(USAGE_FLAG);
 
-  FlagStore store{
-      .short_flag = short_flag, .long_flag = long_flag, .action = action};
+  ARGUE_ASSERT(CONFIG_ERROR,
+               short_flag.empty() ||
+                   (short_flag.size() == 2 &&
+                    static_cast<unsigned char>(short_flag[1]) < 128))
+      << fmt::format("Invalid short flag {}, must be '-' followed by a single "
+                     "ASCII character",
+                     short_flag);
 
   if (long_flag.size() > 0) {
     ARGUE_ASSERT(CONFIG_ERROR, long_flags_.find(long_flag) == long_flags_.end())
         << fmt::format("Duplicate long flag {}", long_flag.c_str());
-    long_flags_[long_flag] = store;
   }
 
   if (short_flag.size() > 0) {
     ARGUE_ASSERT(CONFIG_ERROR,
                  short_flags_.find(short_flag) == short_flags_.end())
         << fmt::format("Duplicate short flag {}", short_flag.c_str());
-    short_flags_[short_flag] = store;
   }
 
+  FlagStore store{.short_flag = short_flag,
+                  .long_flag = long_flag,
+                  .action = action,
+                  .index = flags_.size()};
+  if (long_flag.size() > 0) {
+    long_flags_[long_flag] = store.index;
+  }
+  if (short_flag.size() > 0) {
+    short_flags_[short_flag] = store.index;
+  }
+  flags_.emplace_back(store);
+  frozen_ = false;
+
   FlagHelp help{
       .short_flag = short_flag, .long_flag = long_flag, .action = action};
   flag_help_.emplace_back(help);
@@ -56,6 +72,7 @@ void Parser::add_action(const std::string& name_or_flag,
     case POSITIONAL: {
       action->set_usage(USAGE_POSITIONAL);
       positionals_.emplace_back(action);
+      frozen_ = false;
       PositionalHelp help{.name = name_or_flag, .action = action};
       positional_help_.emplace_back(help);
       break;
@@ -81,6 +98,24 @@ KWargs<typename ElementType<T>::value> Parser::add_argument(
                                                             long_flag, kwargs);
 }
 
+template <class Class, class Field>
+KWargs<typename ElementType<Field>::value> Parser::add_argument(
+    const std::string& short_flag, const std::string& long_flag,
+    Field Class::*dest, KWargs<typename ElementType<Field>::value> kwargs) {
+  return this->add_argument(short_flag, long_flag,
+                            MemberPath<Class, Field>(dest), kwargs);
+}
+
+template <class Class, class Field>
+KWargs<typename ElementType<Field>::value> Parser::add_argument(
+    const std::string& short_flag, const std::string& long_flag,
+    const MemberPath<Class, Field>& dest,
+    KWargs<typename ElementType<Field>::value> kwargs) {
+  kwargs.dest = dest;
+  return this->add_argument<typename ElementType<Field>::value>(
+      short_flag, long_flag, kwargs);
+}
+
 template <typename T>
 KWargs<T> Parser::add_argument(const std::string& name_or_flag,
                                KWargs<T> spec) {
@@ -99,6 +134,23 @@ KWargs<typename ElementType<T>::value> Parser::add_argument(
                                                             kwargs);
 }
 
+template <class Class, class Field>
+KWargs<typename ElementType<Field>::value> Parser::add_argument(
+    const std::string& name_or_flag, Field Class::*dest,
+    KWargs<typename ElementType<Field>::value> kwargs) {
+  return this->add_argument(name_or_flag, MemberPath<Class, Field>(dest),
+                            kwargs);
+}
+
+template <class Class, class Field>
+KWargs<typename ElementType<Field>::value> Parser::add_argument(
+    const std::string& name_or_flag, const MemberPath<Class, Field>& dest,
+    KWargs<typename ElementType<Field>::value> kwargs) {
+  kwargs.dest = dest;
+  return this->add_argument<typename ElementType<Field>::value>(name_or_flag,
+                                                                kwargs);
+}
+
 template <TagNo TAG, class T, class... Args>
 void Parser::add_argument(const std::string& short_flag,
                           const std::string& long_flag,
@@ -118,4 +170,33 @@ void Parser::add_argument(const std::string& name_or_flag,
   this->add_action(name_or_flag, ctx.action);
 }
 
+template <class Class>
+std::shared_ptr<Subparsers> Parser::add_subparsers(
+    const std::string& name, std::string Class::*dest,
+    const SubparserOptions& opts) {
+  return this->add_subparsers(name, MemberPath<Class, std::string>(dest), opts);
+}
+
+template <class Class>
+std::shared_ptr<Subparsers> Parser::add_subparsers(
+    const std::string& name, const MemberPath<Class, std::string>& dest,
+    const SubparserOptions& opts) {
+  std::shared_ptr<Subparsers> action =
+      this->add_subparsers(name, static_cast<std::string*>(nullptr), opts);
+  action->set_destination(dest);
+  return action;
+}
+
+template <class Options>
+std::vector<BatchResult> Parser::parse_batch(
+    const std::vector<std::vector<std::string>>& command_lines,
+    std::vector<Options>* targets, size_t num_threads) const {
+  targets->clear();
+  targets->resize(command_lines.size());
+  return this->parse_batch(
+      command_lines,
+      [targets](size_t idx) { return ParseTarget(&(*targets)[idx]); },
+      num_threads);
+}
+
 }  // namespace argue
@@ -0,0 +1,138 @@
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include "argue/response_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace argue {
+
+// =============================================================================
+//                              Response File
+// =============================================================================
+
+// Consumed pages are released in batches of (at least) this many bytes so that
+// the cost of the system call is amortized over many arguments.
+static const size_t kReleaseChunk = 16 * 1024 * 1024;
+
+static bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+static bool is_special(char c) {
+  return c == '\'' || c == '"' || c == '\\';
+}
+
+ResponseFile::ResponseFile(const char* data, size_t size)
+    : data_(data), size_(size), offset_(0), released_(0) {}
+
+ResponseFile::~ResponseFile() {
+  if (data_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+std::unique_ptr<ResponseFile> ResponseFile::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    close(fd);
+    return nullptr;
+  }
+
+  size_t size = static_cast<size_t>(info.st_size);
+  void* data = nullptr;
+  if (size > 0) {
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // NOTE(josh): the mapping holds its own reference to the file
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  if (data) {
+    madvise(data, size, MADV_SEQUENTIAL);
+  }
+  return std::unique_ptr<ResponseFile>(
+      new ResponseFile(static_cast<const char*>(data), size));
+}
+
+void ResponseFile::release_before(size_t offset) {
+  if (offset < released_ + kReleaseChunk) {
+    return;
+  }
+  // NOTE(josh): the mapping is private and read-only, so released pages are
+  // simply faulted back in from the file if they are touched again. Releasing
+  // does not invalidate any token which still references them.
+  size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t end = offset - (offset % page_size);
+  madvise(const_cast<char*>(data_) + released_, end - released_,
+          MADV_DONTNEED);
+  released_ = end;
+}
+
+bool ResponseFile::next(StringPiece* token, std::string* scratch) {
+  const char* end = data_ + size_;
+  const char* ptr = data_ + offset_;
+  while (ptr < end && is_space(*ptr)) {
+    ++ptr;
+  }
+  if (ptr == end) {
+    offset_ = size_;
+    return false;
+  }
+
+  const char* start = ptr;
+  release_before(start - data_);
+  while (ptr < end && !is_space(*ptr) && !is_special(*ptr)) {
+    ++ptr;
+  }
+  if (ptr == end || is_space(*ptr)) {
+    offset_ = ptr - data_;
+    *token = StringPiece(start, ptr - start);
+    return true;
+  }
+
+  // The argument is quoted or escaped, so it must be copied out of the
+  // mapping.
+  scratch->assign(start, ptr);
+  char quote = 0;
+  for (; ptr < end; ++ptr) {
+    char c = *ptr;
+    if (quote == '\'') {
+      if (c == '\'') {
+        quote = 0;
+      } else {
+        scratch->push_back(c);
+      }
+    } else if (quote == '"') {
+      if (c == '"') {
+        quote = 0;
+      } else if (c == '\\' && ptr + 1 < end &&
+                 (ptr[1] == '"' || ptr[1] == '\\')) {
+        scratch->push_back(*++ptr);
+      } else {
+        scratch->push_back(c);
+      }
+    } else if (is_space(c)) {
+      break;
+    } else if (c == '\'' || c == '"') {
+      quote = c;
+    } else if (c == '\\' && ptr + 1 < end) {
+      scratch->push_back(*++ptr);
+    } else {
+      scratch->push_back(c);
+    }
+  }
+  offset_ = ptr - data_;
+  *token = StringPiece(*scratch);
+  return true;
+}
+
+}  // namespace argue
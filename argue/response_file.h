@@ -0,0 +1,63 @@
+#pragma once
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "argue/util.h"
+
+namespace argue {
+
+// =============================================================================
+//                              Response File
+// =============================================================================
+
+// A file of additional command line arguments, referenced on the command line
+// as `@path`.
+/* The file is memory mapped and split into arguments one at a time, as the
+ * parser asks for them, so the size of the file does not bound the size of
+ * the command line and the whole file is never held in memory at once. Pages
+ * of the mapping which have been consumed are periodically released.
+ *
+ * Arguments are separated by whitespace. Within an argument:
+ *
+ *  * text between single quotes is taken literally
+ *  * text between double quotes is taken literally, except that a backslash
+ *    escapes a double quote or a backslash
+ *  * outside of quotes, a backslash escapes the next character (including
+ *    whitespace and quotes)
+ *
+ * An unterminated quote extends to the end of the file. Arguments which
+ * contain no quotes or backslashes reference the mapping directly and are not
+ * copied. */
+class ResponseFile {
+ public:
+  ~ResponseFile();
+
+  // Map the file at `path`. Returns nullptr if the file cannot be opened or
+  // mapped.
+  static std::unique_ptr<ResponseFile> open(const std::string& path);
+
+  // Split the next argument out of the file. Returns false if there are no
+  // more arguments. If the argument has to be unquoted it is written to
+  // `scratch` and `token` references `scratch`, otherwise `token` references
+  // the mapping, which is valid for the lifetime of this object.
+  bool next(StringPiece* token, std::string* scratch);
+
+ private:
+  ResponseFile(const char* data, size_t size);
+  ResponseFile(const ResponseFile&) = delete;
+  ResponseFile& operator=(const ResponseFile&) = delete;
+
+  // Release pages of the mapping which lie entirely before `offset`, if
+  // enough of them have accumulated since the last release.
+  void release_before(size_t offset);
+
+  const char* data_;  //< start of the mapping, or nullptr if the file is empty
+  size_t size_;       //< size of the file
+  size_t offset_;     //< offset of the first character not yet tokenized
+  size_t released_;   //< offset before which pages have been released
+};
+
+}  // namespace argue
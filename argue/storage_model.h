@@ -7,10 +7,65 @@ namespace argue {
 //                           Storage Model
 // =============================================================================
 
+// Locates a destination which is fixed when the parser is built
+template <class Container>
+class PointerLocation {
+ public:
+  PointerLocation(Container* ptr);  // NOLINT(runtime/explicit)
+
+  // Return the destination. The parse target is ignored.
+  Container* locate(void* target) const;
+
+ private:
+  Container* ptr_;
+};
+
+// A path from an object of type `Class` to one of its, possibly nested,
+// members of type `Field`.
+/* Destinations declared this way are located within the target object which
+ * is supplied to each parse call, rather than being fixed when the parser is
+ * built. A path is usually constructed implicitly from a pointer to member,
+ * e.g. `&Options::threads`. Use `member()` to reach into nested structs, e.g.
+ * `member(&Options::foo, &Options::Foo::arg1)`. */
+template <class Class, class Field>
+class MemberPath {
+ public:
+  typedef Class ClassType;
+  typedef Field FieldType;
+
+  MemberPath(Field Class::*member);  // NOLINT(runtime/explicit)
+  explicit MemberPath(const std::function<Field*(Class*)>& get);
+
+  // Return a pointer to the member within `object`
+  Field* get(Class* object) const;
+
+  // Return a pointer to the member within the parse target, which must be an
+  // object of type `Class`.
+  Field* locate(void* target) const;
+
+ private:
+  std::function<Field*(Class*)> get_;
+};
+
+// Return the path to `inner` within the member `outer` of `Class`
+template <class Class, class Mid, class Field>
+MemberPath<Class, Field> member(Mid Class::*outer, Field Mid::*inner);
+
+// Extend a path with a member of the struct that it leads to. Nest calls to
+// reach arbitrarily deep members.
+template <class Class, class Mid, class Field>
+MemberPath<Class, Field> member(const MemberPath<Class, Mid>& outer,
+                                Field Mid::*inner);
+
 // Abstract interface into different container types
 /* All containers of a particular value type are wrapped by some class which
  * derives from StorageModel<T>, allowing us to interface with those containers
- * without knowing their remaining template parameters */
+ * without knowing their remaining template parameters.
+ *
+ * Each method is given the target object supplied to the parse call (or
+ * nullptr if there isn't one). Models for destinations which were fixed when
+ * the parser was built ignore it. Models for member destinations write into
+ * the member of the target. */
 template <typename T>
 class StorageModel {
  public:
@@ -20,75 +75,149 @@ class StorageModel {
   /* Note that the capacity_hint might be zero, in the case of "append"
    * type actions, or narg="+""... in which case the storage should be
    * large enough to hold all the expected values, or should be growable. */
-  virtual void init(size_t capacity_hint) = 0;
+  virtual void init(void* target, size_t capacity_hint) = 0;
 
   // Append an element to the list model
-  virtual void append(const T& value) = 0;
+  virtual void append(void* target, const T& value) = 0;
+
+  // Append an element to the list model, taking ownership of its contents
+  /* The default implementation copies. Models override this to move the
+   * parsed value into the container so that each value is copied at most
+   * once on its way from the command line to the destination. */
+  virtual void append(void* target, T&& value) {
+    append(target, static_cast<const T&>(value));
+  }
 
   // Assign a value to the scalar model
-  virtual void assign(const T& value) = 0;
+  virtual void assign(void* target, const T& value) = 0;
+
+  // Assign a value to the scalar model, taking ownership of its contents
+  virtual void assign(void* target, T&& value) {
+    assign(target, static_cast<const T&>(value));
+  }
+
+  // Return true if values are delivered as soon as they are parsed rather
+  // than stored. Defaults for such a destination are only delivered at the
+  // end of the parse, see `ActionBase::apply_unused_defaults`.
+  virtual bool is_streaming() const {
+    return false;
+  }
 
  protected:
   std::string type_name_;
 };
 
 // Abstract the interface into a `std::list`
-template <typename T, class Allocator>
+template <typename T, class Allocator,
+          class Location = PointerLocation<std::list<T, Allocator>>>
 class ListModel : public StorageModel<T> {
  public:
-  explicit ListModel(std::list<T, Allocator>* dest);
+  explicit ListModel(const Location& dest);
   virtual ~ListModel() {}
 
-  void init(size_t /*capacity_hint*/) override;
-  void append(const T& value) override;
-  void assign(const T& value) override;
+  void init(void* target, size_t /*capacity_hint*/) override;
+  void append(void* target, const T& value) override;
+  void append(void* target, T&& value) override;
+  void assign(void* target, const T& value) override;
 
-  static std::shared_ptr<StorageModel<T>> create(
-      std::list<T, Allocator>* dest) {
-    return std::make_shared<ListModel<T, Allocator>>(dest);
+  static std::shared_ptr<StorageModel<T>> create(const Location& dest) {
+    return std::make_shared<ListModel<T, Allocator, Location>>(dest);
   }
 
  private:
-  std::list<T, Allocator>* dest_;
+  Location dest_;
 };
 
 // Abstract the interface into a `std::vector`
-template <typename T, class Allocator>
+template <typename T, class Allocator,
+          class Location = PointerLocation<std::vector<T, Allocator>>>
 class VectorModel : public StorageModel<T> {
  public:
-  explicit VectorModel(std::vector<T, Allocator>* dest);
+  explicit VectorModel(const Location& dest);
   virtual ~VectorModel() {}
 
-  void init(size_t capacity_hint);
-  void append(const T& value);
-  void assign(const T& value);
+  void init(void* target, size_t capacity_hint) override;
+  void append(void* target, const T& value) override;
+  void append(void* target, T&& value) override;
+  void assign(void* target, const T& value) override;
 
-  static std::shared_ptr<StorageModel<T>> create(
-      std::vector<T, Allocator>* dest) {
-    return std::make_shared<VectorModel<T, Allocator>>(dest);
+  static std::shared_ptr<StorageModel<T>> create(const Location& dest) {
+    return std::make_shared<VectorModel<T, Allocator, Location>>(dest);
   }
 
  private:
-  std::vector<T, Allocator>* dest_;
+  Location dest_;
 };
 
 // Abstract interface into a scalar pointer
-template <typename T>
+template <typename T, class Location = PointerLocation<T>>
 class ScalarModel : public StorageModel<T> {
  public:
-  explicit ScalarModel(T* dest);
+  explicit ScalarModel(const Location& dest);
   virtual ~ScalarModel() {}
 
-  void init(size_t capacity_hint);
-  void append(const T& value);
-  void assign(const T& value);
+  void init(void* target, size_t capacity_hint) override;
+  void append(void* target, const T& value) override;
+  void assign(void* target, const T& value) override;
+  void assign(void* target, T&& value) override;
 
-  static std::shared_ptr<StorageModel<T>> create(T* dest) {
-    return std::make_shared<ScalarModel<T>>(dest);
+  static std::shared_ptr<StorageModel<T>> create(const Location& dest) {
+    return std::make_shared<ScalarModel<T, Location>>(dest);
   }
 
  private:
-  T* dest_;
+  Location dest_;
 };
 
+// Deliver each value to a callback as soon as it is parsed
+/* Nothing is stored. For a list argument (e.g. `nargs='*'`) the callback is
+ * called once per value, in order, as the parser reaches it. The program can
+ * start working on the first value before the rest are parsed, and memory
+ * use does not grow with the number of values. Note that a later value may
+ * still fail to parse after earlier values were delivered. A default value is
+ * only delivered once the parse has succeeded, and only if the argument was
+ * not given, so the callback never sees a default that is then overridden. */
+template <typename T>
+class CallbackModel : public StorageModel<T> {
+ public:
+  typedef std::function<void(T&&)> Callback;
+
+  explicit CallbackModel(const Callback& callback);
+  virtual ~CallbackModel() {}
+
+  void init(void* target, size_t capacity_hint) override;
+  void append(void* target, const T& value) override;
+  void append(void* target, T&& value) override;
+  void assign(void* target, const T& value) override;
+  void assign(void* target, T&& value) override;
+  bool is_streaming() const override;
+
+  static std::shared_ptr<StorageModel<T>> create(const Callback& callback) {
+    return std::make_shared<CallbackModel<T>>(callback);
+  }
+
+ private:
+  Callback callback_;
+};
+
+// Return a destination which passes each parsed value to `callback`, e.g.
+// `dest = argue::each<std::string>(process_file)`. See `CallbackModel`.
+template <typename T>
+std::shared_ptr<StorageModel<T>> each(
+    const typename CallbackModel<T>::Callback& callback);
+
+// Construct the storage model for a member destination. The overload is
+// selected by the type of the member: a scalar, a list, or a vector.
+template <typename T, class Class>
+std::shared_ptr<StorageModel<T>> make_member_model(
+    const MemberPath<Class, T>& path);
+
+template <typename T, class Class, class Allocator>
+std::shared_ptr<StorageModel<T>> make_member_model(
+    const MemberPath<Class, std::list<T, Allocator>>& path);
+
+template <typename T, class Class, class Allocator>
+std::shared_ptr<StorageModel<T>> make_member_model(
+    const MemberPath<Class, std::vector<T, Allocator>>& path);
+
 }  // namespace argue
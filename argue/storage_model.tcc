@@ -8,66 +8,189 @@
 
 namespace argue {
 
-template <typename T, class Allocator>
-ListModel<T, Allocator>::ListModel(std::list<T, Allocator>* dest)
+template <class Container>
+PointerLocation<Container>::PointerLocation(Container* ptr) : ptr_(ptr) {}
+
+template <class Container>
+Container* PointerLocation<Container>::locate(void* /*target*/) const {
+  return ptr_;
+}
+
+template <class Class, class Field>
+MemberPath<Class, Field>::MemberPath(Field Class::*member)
+    : get_([member](Class* object) { return &(object->*member); }) {}
+
+template <class Class, class Field>
+MemberPath<Class, Field>::MemberPath(
+    const std::function<Field*(Class*)>& get)
+    : get_(get) {}
+
+template <class Class, class Field>
+Field* MemberPath<Class, Field>::get(Class* object) const {
+  return get_(object);
+}
+
+template <class Class, class Field>
+Field* MemberPath<Class, Field>::locate(void* target) const {
+  ARGUE_ASSERT(BUG, target != nullptr)
+      << "A member destination of " << type_string<Class>()
+      << " was used without a parse target";
+  return get_(static_cast<Class*>(target));
+}
+
+template <class Class, class Mid, class Field>
+MemberPath<Class, Field> member(Mid Class::*outer, Field Mid::*inner) {
+  return member(MemberPath<Class, Mid>(outer), inner);
+}
+
+template <class Class, class Mid, class Field>
+MemberPath<Class, Field> member(const MemberPath<Class, Mid>& outer,
+                                Field Mid::*inner) {
+  return MemberPath<Class, Field>(
+      [outer, inner](Class* object) { return &(outer.get(object)->*inner); });
+}
+
+template <typename T, class Allocator, class Location>
+ListModel<T, Allocator, Location>::ListModel(const Location& dest)
     : dest_(dest) {
   this->type_name_ = type_string<ListModel<T, Allocator>>();
 }
 
-template <typename T, class Allocator>
-void ListModel<T, Allocator>::init(size_t /*capacity_hint*/) {
-  dest_->clear();
+template <typename T, class Allocator, class Location>
+void ListModel<T, Allocator, Location>::init(void* target,
+                                             size_t /*capacity_hint*/) {
+  dest_.locate(target)->clear();
+}
+
+template <typename T, class Allocator, class Location>
+void ListModel<T, Allocator, Location>::append(void* target, const T& value) {
+  dest_.locate(target)->emplace_back(value);
 }
 
-template <typename T, class Allocator>
-void ListModel<T, Allocator>::append(const T& value) {
-  dest_->emplace_back(value);
+template <typename T, class Allocator, class Location>
+void ListModel<T, Allocator, Location>::append(void* target, T&& value) {
+  dest_.locate(target)->emplace_back(std::move(value));
 }
 
-template <typename T, class Allocator>
-void ListModel<T, Allocator>::assign(const T& value) {
+template <typename T, class Allocator, class Location>
+void ListModel<T, Allocator, Location>::assign(void* target, const T& value) {
   ARGUE_THROW(CONFIG_ERROR) << "You can't use a ListModel in a scalar context";
 }
 
-template <typename T, class Allocator>
-VectorModel<T, Allocator>::VectorModel(std::vector<T, Allocator>* dest)
+template <typename T, class Allocator, class Location>
+VectorModel<T, Allocator, Location>::VectorModel(const Location& dest)
     : dest_(dest) {
   this->type_name_ = type_string<VectorModel<T, Allocator>>();
 }
 
-template <typename T, class Allocator>
-void VectorModel<T, Allocator>::init(size_t capacity_hint) {
-  dest_->clear();
-  dest_->reserve(capacity_hint);
+template <typename T, class Allocator, class Location>
+void VectorModel<T, Allocator, Location>::init(void* target,
+                                               size_t capacity_hint) {
+  std::vector<T, Allocator>* dest = dest_.locate(target);
+  dest->clear();
+  dest->reserve(capacity_hint);
 }
 
-template <typename T, class Allocator>
-void VectorModel<T, Allocator>::append(const T& value) {
-  dest_->emplace_back(value);
+template <typename T, class Allocator, class Location>
+void VectorModel<T, Allocator, Location>::append(void* target,
+                                                 const T& value) {
+  dest_.locate(target)->emplace_back(value);
 }
 
-template <typename T, class Allocator>
-void VectorModel<T, Allocator>::assign(const T& value) {
+template <typename T, class Allocator, class Location>
+void VectorModel<T, Allocator, Location>::append(void* target, T&& value) {
+  dest_.locate(target)->emplace_back(std::move(value));
+}
+
+template <typename T, class Allocator, class Location>
+void VectorModel<T, Allocator, Location>::assign(void* target,
+                                                 const T& value) {
   ARGUE_THROW(CONFIG_ERROR)
       << "You can't use a VectorModel in a scalar context";
 }
 
+template <typename T, class Location>
+ScalarModel<T, Location>::ScalarModel(const Location& dest) : dest_{dest} {}
+
+template <typename T, class Location>
+void ScalarModel<T, Location>::init(void* target, size_t capacity_hint) {
+  ARGUE_THROW(CONFIG_ERROR) << "You can't use a ScalarModel in a list context";
+}
+
+template <typename T, class Location>
+void ScalarModel<T, Location>::append(void* target, const T& value) {
+  ARGUE_THROW(CONFIG_ERROR) << "You can't use a ScalarModel in a list context";
+}
+
+template <typename T, class Location>
+void ScalarModel<T, Location>::assign(void* target, const T& value) {
+  (*dest_.locate(target)) = value;
+}
+
+template <typename T, class Location>
+void ScalarModel<T, Location>::assign(void* target, T&& value) {
+  (*dest_.locate(target)) = std::move(value);
+}
+
+template <typename T, class Class>
+std::shared_ptr<StorageModel<T>> make_member_model(
+    const MemberPath<Class, T>& path) {
+  return ScalarModel<T, MemberPath<Class, T>>::create(path);
+}
+
+template <typename T, class Class, class Allocator>
+std::shared_ptr<StorageModel<T>> make_member_model(
+    const MemberPath<Class, std::list<T, Allocator>>& path) {
+  return ListModel<T, Allocator,
+                   MemberPath<Class, std::list<T, Allocator>>>::create(path);
+}
+
+template <typename T, class Class, class Allocator>
+std::shared_ptr<StorageModel<T>> make_member_model(
+    const MemberPath<Class, std::vector<T, Allocator>>& path) {
+  return VectorModel<T, Allocator,
+                     MemberPath<Class, std::vector<T, Allocator>>>::create(
+      path);
+}
+
 template <typename T>
-ScalarModel<T>::ScalarModel(T* dest) : dest_{dest} {}
+CallbackModel<T>::CallbackModel(const Callback& callback)
+    : callback_(callback) {
+  this->type_name_ = type_string<CallbackModel<T>>();
+}
 
 template <typename T>
-void ScalarModel<T>::init(size_t capacity_hint) {
-  ARGUE_THROW(CONFIG_ERROR) << "You can't use a ScalarModel in a list context";
+void CallbackModel<T>::init(void* /*target*/, size_t /*capacity_hint*/) {}
+
+template <typename T>
+void CallbackModel<T>::append(void* /*target*/, const T& value) {
+  callback_(T(value));
 }
 
 template <typename T>
-void ScalarModel<T>::append(const T& value) {
-  ARGUE_THROW(CONFIG_ERROR) << "You can't use a ScalarModel in a list context";
+void CallbackModel<T>::append(void* /*target*/, T&& value) {
+  callback_(std::move(value));
+}
+
+template <typename T>
+void CallbackModel<T>::assign(void* /*target*/, const T& value) {
+  callback_(T(value));
+}
+
+template <typename T>
+void CallbackModel<T>::assign(void* /*target*/, T&& value) {
+  callback_(std::move(value));
+}
+
+template <typename T>
+bool CallbackModel<T>::is_streaming() const {
+  return true;
 }
 
 template <typename T>
-void ScalarModel<T>::assign(const T& value) {
-  (*dest_) = value;
+std::shared_ptr<StorageModel<T>> each(
+    const typename CallbackModel<T>::Callback& callback) {
+  return CallbackModel<T>::create(callback);
 }
 
 }  // namespace argue
@@ -1,5 +1,14 @@
 // Copyright 2018 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include <cctype>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <map>
+
+#include "argue/elf_note.h"
+#if ARGUE_HAVE_ELF_NOTES
+#include <link.h>
+#endif
 
 #include <gtest/gtest.h>
 
@@ -439,3 +448,1137 @@ TEST(FlagTest, MatchUniquePrefix) {
   ASSERT_EQ(argue::PARSE_EXCEPTION, parser.parse_args({"--do"}, &logstrm))
       << logstrm.str();
 }
+
+TEST(ArgvTest, ParsesDirectlyFromArgv) {
+  std::stringstream logstrm;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "argv-test"});
+
+  std::string name;
+  std::vector<std::string> files;
+  parser.add_argument("-n", "--name", &name);
+  parser.add_argument("files", &files, {.nargs = "+"});
+
+  char arg0[] = "argv-test";
+  char arg1[] = "--name";
+  char arg2[] = "a-name-long-enough-to-need-an-allocation";
+  char arg3[] = "foo.txt";
+  char arg4[] = "bar.txt";
+  char* argv[] = {arg0, arg1, arg2, arg3, arg4, nullptr};
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args(5, argv, &logstrm))
+      << logstrm.str();
+  EXPECT_EQ(arg2, name);
+  EXPECT_EQ((std::vector<std::string>{"foo.txt", "bar.txt"}), files);
+}
+
+TEST(ArgvTest, ListIsLeftWithUnconsumedArguments) {
+  std::stringstream logstrm;
+  argue::Parser parser;
+  ResetParser(&parser);
+
+  int foo = 0;
+  parser.add_argument("foo", &foo, {});
+  std::list<std::string> args = {"1", "2", "3"};
+  EXPECT_EQ(argue::PARSE_EXCEPTION, parser.parse_args(&args, &logstrm));
+  EXPECT_EQ(1, foo);
+  EXPECT_EQ((std::list<std::string>{"2", "3"}), args);
+}
+
+TEST(SessionTest, ParserIsReusable) {
+  std::stringstream logstrm;
+  argue::Parser parser;
+  ResetParser(&parser);
+
+  int foo = 0;
+  std::string bar;
+  parser.add_argument("foo", &foo, {});
+  parser.add_argument("-b", "--bar", &bar, {.required = true});
+  parser.freeze();
+
+  const argue::Parser& const_parser = parser;
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            const_parser.parse_args({"-b", "hello", "1"}, &logstrm))
+      << logstrm.str();
+  EXPECT_EQ(1, foo);
+  EXPECT_EQ("hello", bar);
+
+  // A flag consumed in one parse must be available again in the next
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            const_parser.parse_args({"2", "--bar", "world"}, &logstrm))
+      << logstrm.str();
+  EXPECT_EQ(2, foo);
+  EXPECT_EQ("world", bar);
+
+  // But not twice within the same parse
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            const_parser.parse_args({"-b", "a", "--bar", "b", "3"}, &logstrm));
+
+  // And a required flag is required
+  EXPECT_EQ(argue::PARSE_EXCEPTION, const_parser.parse_args({"4"}, &logstrm));
+}
+
+TEST(FreezeTest, ConstParseRequiresFrozenTables) {
+  std::stringstream logstrm;
+  argue::Parser parser;
+  ResetParser(&parser);
+
+  int foo = 0;
+  int bar = 0;
+  parser.add_argument("-f", "--foo", &foo);
+  parser.freeze();
+  EXPECT_TRUE(parser.is_frozen());
+
+  const argue::Parser& const_parser = parser;
+  ASSERT_EQ(argue::PARSE_FINISHED, const_parser.parse_args({"-f", "1"}))
+      << logstrm.str();
+  EXPECT_EQ(1, foo);
+
+  // Adding an argument thaws the parser, so it can no longer be used through
+  // a const reference...
+  parser.add_argument("-b", "--bar", &bar);
+  EXPECT_FALSE(parser.is_frozen());
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            const_parser.parse_args({"-b", "2"}, &logstrm));
+
+  // ...but a non-const parse will re-freeze it
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args({"-b", "2"}, &logstrm))
+      << logstrm.str();
+  EXPECT_TRUE(parser.is_frozen());
+  EXPECT_EQ(2, bar);
+}
+
+TEST(FreezeTest, ManyFlags) {
+  std::stringstream logstrm;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false});
+
+  std::vector<int> values(400, 0);
+  for (size_t idx = 0; idx < values.size(); ++idx) {
+    parser.add_argument(fmt::format("--flag-{:03d}", idx), &values[idx]);
+  }
+  int short_value = 0;
+  parser.add_argument("-Z", &short_value);
+
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            parser.parse_args({"--flag-000", "1", "--flag-399", "2",
+                               "--flag-250", "3", "-Z", "4"},
+                              &logstrm))
+      << logstrm.str();
+  EXPECT_EQ(1, values[0]);
+  EXPECT_EQ(2, values[399]);
+  EXPECT_EQ(3, values[250]);
+  EXPECT_EQ(4, short_value);
+
+  EXPECT_EQ(argue::PARSE_EXCEPTION, parser.parse_args({"-Y", "1"}, &logstrm));
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.parse_args({"--flag-4", "1"}, &logstrm));
+}
+
+TEST(SubparserTest, DefaultsOnlyForSelectedCommand) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser);
+
+  std::string command;
+  std::string foo_value = "unset";
+  std::string bar_value = "unset";
+  auto subparsers = parser.add_subparsers("command", &command);
+  auto foo_parser = subparsers->add_parser("foo");
+  foo_parser->add_argument("-a", &foo_value,
+                           {.default_ = std::string("foo-default")});
+  auto bar_parser = subparsers->add_parser("bar");
+  bar_parser->add_argument("-a", &bar_value,
+                           {.default_ = std::string("bar-default")});
+
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args({"foo"}, &logout))
+      << logout.str();
+  EXPECT_EQ("foo-default", foo_value);
+  EXPECT_EQ("unset", bar_value);
+
+  // Defaults are re-applied on every parse
+  foo_value = "unset";
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args({"foo"}, &logout))
+      << logout.str();
+  EXPECT_EQ("foo-default", foo_value);
+  EXPECT_EQ("unset", bar_value);
+}
+
+TEST(FreezeTest, ConfigErrorsAreReported) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser);
+
+  int foo = 0;
+  parser.add_argument("-f", "--foo", &foo, {.action = "store_const"});
+  EXPECT_EQ(argue::PARSE_EXCEPTION, parser.parse_args({}, &logout));
+  EXPECT_NE(std::string::npos, logout.str().find("CONFIG_ERROR"))
+      << logout.str();
+}
+
+TEST(SubparserTest, LazySubparsersAreBuiltOnDispatch) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = true, .name = "lazy"});
+
+  std::string command;
+  std::string foo_value;
+  int builds = 0;
+  auto subparsers = parser.add_subparsers("command", &command);
+  subparsers->add_lazy_parser(
+      "foo", {.help = "does foo"}, [&](argue::Parser* sub) {
+        builds++;
+        sub->add_argument("-a", &foo_value);
+      });
+  subparsers->add_lazy_parser("bar", {.help = "does bar"},
+                              [&](argue::Parser* sub) { builds++; });
+
+  // Help enumerates the subcommands without building them
+  ASSERT_EQ(argue::PARSE_ABORTED, parser.parse_args({"--help"}, &logout));
+  EXPECT_NE(std::string::npos, logout.str().find("does foo"));
+  EXPECT_NE(std::string::npos, logout.str().find("does bar"));
+  EXPECT_EQ(0, builds);
+
+  logout.str("");
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            parser.parse_args({"foo", "-a", "hello"}, &logout))
+      << logout.str();
+  EXPECT_EQ("foo", command);
+  EXPECT_EQ("hello", foo_value);
+  EXPECT_EQ(1, builds);
+
+  // The parser is only built once
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            parser.parse_args({"foo", "-a", "world"}, &logout))
+      << logout.str();
+  EXPECT_EQ("world", foo_value);
+  EXPECT_EQ(1, builds);
+}
+
+TEST(SubparserTest, AliasesAndUniquePrefixes) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "git"});
+
+  std::string command;
+  auto subparsers = parser.add_subparsers("command", &command);
+  subparsers->add_parser("checkout", {.help = "", .aliases = {"co"}});
+  subparsers->add_parser("commit", {.help = "", .aliases = {"ci"}});
+  subparsers->add_parser("status", {.help = "", .aliases = {"st", "stat"}});
+
+  // Exact names and aliases both dispatch to the named command
+  for (const char* arg : {"checkout", "co"}) {
+    command.clear();
+    ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args({arg}, &logout))
+        << logout.str();
+    EXPECT_EQ("checkout", command);
+  }
+
+  // A unique prefix selects a command, even if it is the prefix of more than
+  // one of the aliases of that command.
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args({"chec"}, &logout))
+      << logout.str();
+  EXPECT_EQ("checkout", command);
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args({"s"}, &logout))
+      << logout.str();
+  EXPECT_EQ("status", command);
+
+  // An ambiguous prefix is an error
+  logout.str("");
+  ASSERT_EQ(argue::PARSE_EXCEPTION, parser.parse_args({"c"}, &logout));
+  EXPECT_NE(std::string::npos, logout.str().find("not unique")) << logout.str();
+
+  logout.str("");
+  ASSERT_EQ(argue::PARSE_EXCEPTION, parser.parse_args({"push"}, &logout));
+  EXPECT_NE(std::string::npos, logout.str().find("checkout', 'commit"))
+      << logout.str();
+
+  // Names and aliases must be unique
+  EXPECT_THROW(
+      subparsers->add_parser("costume", {.help = "", .aliases = {"st"}}),
+      argue::Exception);
+  EXPECT_THROW(subparsers->add_parser("co"), argue::Exception);
+  EXPECT_THROW(subparsers->add_parser("log", {.help = "", .aliases = {"log"}}),
+               argue::Exception);
+  EXPECT_THROW(
+      subparsers->add_parser("log", {.help = "", .aliases = {"lg", "lg"}}),
+      argue::Exception);
+
+  // A rejected command leaves the index untouched
+  EXPECT_EQ(nullptr, subparsers->find_command("log"));
+  EXPECT_EQ(nullptr, subparsers->find_command("lg"));
+  EXPECT_NE(nullptr, subparsers->add_parser("log"));
+}
+
+TEST(ErrorTest, TryParseReturnsStructuredErrors) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  int jobs = 0;
+  std::string command;
+  std::vector<int> values;
+  std::string bar_value;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-j", "--jobs", dest = &jobs, choices = {1, 2, 4});
+  auto subparsers = parser.add_subparsers("command", &command);
+  auto foo = subparsers->add_parser("foo");
+  foo->add_argument("values", nargs = "+", dest = &values);
+  auto bar = subparsers->add_parser("bar");
+  bar->add_argument("-b", "--bar", dest = &bar_value, required = true);
+  parser.freeze();
+
+  argue::ParseError error{};
+  EXPECT_EQ(argue::PARSE_FINISHED,
+            parser.try_parse_args({"-j", "2", "foo", "1", "2"}, &error));
+  EXPECT_EQ(2, jobs);
+  EXPECT_EQ(std::vector<int>({1, 2}), values);
+
+  error = {};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"-j", "3", "foo", "1"}, &error, &logout));
+  EXPECT_EQ(argue::Exception::INPUT_ERROR, error.type);
+  EXPECT_EQ(1, error.token_index);
+  EXPECT_EQ("Invalid value '3' choose from '1, 2, 4'", error.message);
+  EXPECT_NE(std::string::npos, error.usage.find("prog")) << error.usage;
+
+  error = {};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"foo", "1", "x"}, &error, &logout));
+  EXPECT_EQ(2, error.token_index);
+  EXPECT_EQ("Invalid value 'x'", error.message);
+  EXPECT_NE(std::string::npos, error.usage.find("foo")) << error.usage;
+
+  error = {};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"--jbos", "1"}, &error, &logout));
+  EXPECT_EQ(0, error.token_index);
+  EXPECT_EQ("Unrecognized long flag: --jbos", error.message);
+
+  error = {};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"baz"}, &error, &logout));
+  EXPECT_EQ(0, error.token_index);
+
+  error = {};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"bar"}, &error, &logout));
+  EXPECT_EQ(1, error.token_index);
+  EXPECT_EQ("Missing required flag (-b,--bar)", error.message);
+
+  error = {};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"bar", "-b"}, &error, &logout));
+  EXPECT_EQ(2, error.token_index);
+
+  // Nothing is written to the log by a failed parse
+  EXPECT_EQ("", logout.str());
+}
+
+TEST(ErrorTest, ParseArgsPrintsTheErrorAndUsage) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  int jobs = 0;
+  std::string command;
+  std::string bar_value;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-j", "--jobs", dest = &jobs);
+  auto subparsers = parser.add_subparsers("command", &command);
+  auto bar = subparsers->add_parser("bar");
+  bar->add_argument("-b", "--bar", dest = &bar_value, required = true);
+  parser.freeze();
+
+  // Any input error is followed by the usage of the parser which rejected it
+  EXPECT_EQ(argue::PARSE_EXCEPTION, parser.parse_args({"-j", "x"}, &logout));
+  EXPECT_EQ("INPUT_ERROR: Invalid value 'x'\n" + parser.get_usage_string(),
+            logout.str());
+
+  logout.str("");
+  EXPECT_EQ(argue::PARSE_EXCEPTION, parser.parse_args({"bar"}, &logout));
+  EXPECT_EQ("INPUT_ERROR: Missing required flag (-b,--bar)\n" +
+                bar->get_usage_string(),
+            logout.str());
+}
+
+struct MemberTestOptions {
+  int threads = 0;
+  std::vector<std::string> files;
+  std::string command;
+  struct Foo {
+    bool verbose = false;
+  } foo;
+};
+
+TEST(MemberTest, OneParserFillsManyTargets) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-t", "--threads", dest = &MemberTestOptions::threads,
+                      default_ = 1);
+  auto subparsers =
+      parser.add_subparsers("command", &MemberTestOptions::command);
+  auto foo = subparsers->add_parser("foo");
+  foo->add_argument("-v", "--verbose", action = "store_true",
+                    dest = argue::member(&MemberTestOptions::foo,
+                                         &MemberTestOptions::Foo::verbose));
+  foo->add_argument("files", nargs = "*", dest = &MemberTestOptions::files);
+  parser.freeze();
+
+  const argue::Parser& const_parser = parser;
+  MemberTestOptions first{};
+  MemberTestOptions second{};
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            const_parser.parse_args(&first, {"-t", "4", "foo", "a", "b"},
+                                    &logout))
+      << logout.str();
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            const_parser.parse_args(&second, {"foo", "-v", "c"}, &logout))
+      << logout.str();
+
+  EXPECT_EQ(4, first.threads);
+  EXPECT_EQ("foo", first.command);
+  EXPECT_FALSE(first.foo.verbose);
+  EXPECT_EQ(std::vector<std::string>({"a", "b"}), first.files);
+
+  EXPECT_EQ(1, second.threads);
+  EXPECT_EQ("foo", second.command);
+  EXPECT_TRUE(second.foo.verbose);
+  EXPECT_EQ(std::vector<std::string>({"c"}), second.files);
+
+  argue::ParseError error{};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            const_parser.try_parse_args({"foo"}, &error, &logout));
+  EXPECT_EQ(argue::Exception::CONFIG_ERROR, error.type);
+
+  error = {};
+  struct Other {
+    int threads;
+  } other{};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            const_parser.try_parse_args(&other, {"foo"}, &error, &logout));
+  EXPECT_EQ(argue::Exception::CONFIG_ERROR, error.type);
+}
+
+TEST(BatchTest, ParsesEachLineIntoItsOwnTarget) {
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "job"});
+
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-t", "--threads", dest = &MemberTestOptions::threads,
+                      choices = {1, 2, 4, 8});
+  parser.add_argument("files", nargs = "*", dest = &MemberTestOptions::files);
+  parser.freeze();
+
+  std::vector<std::vector<std::string>> lines;
+  for (size_t idx = 0; idx < 1000; ++idx) {
+    if (idx % 100 == 7) {
+      lines.push_back({"a", "--threads", "3"});
+    } else {
+      lines.push_back({"--threads", std::to_string(1 << (idx % 4)),
+                       std::to_string(idx)});
+    }
+  }
+
+  std::vector<MemberTestOptions> targets;
+  std::vector<argue::BatchResult> results =
+      parser.parse_batch(lines, &targets, 4);
+  ASSERT_EQ(lines.size(), results.size());
+  ASSERT_EQ(lines.size(), targets.size());
+  for (size_t idx = 0; idx < lines.size(); ++idx) {
+    if (idx % 100 == 7) {
+      EXPECT_EQ(argue::PARSE_EXCEPTION, results[idx].result);
+      EXPECT_EQ(argue::Exception::INPUT_ERROR, results[idx].error.type);
+      EXPECT_EQ(2, results[idx].error.token_index);
+    } else {
+      EXPECT_EQ(argue::PARSE_FINISHED, results[idx].result)
+          << results[idx].error.message;
+      EXPECT_EQ(1 << (idx % 4), targets[idx].threads);
+      EXPECT_EQ(std::vector<std::string>({std::to_string(idx)}),
+                targets[idx].files);
+    }
+  }
+}
+
+TEST(BatchTest, ExceptionsAreReportedWithTheUsage) {
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "job"});
+
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-c", "--count", dest = argue::each<int>([](int value) {
+                        if (value > 10) {
+                          ARGUE_THROW(INPUT_ERROR) << "Count is too large";
+                        }
+                      }));
+  parser.freeze();
+
+  std::vector<argue::BatchResult> results = parser.parse_batch(
+      {{"-c", "1"}, {"-c", "11"}},
+      [](size_t) { return argue::ParseTarget(); }, 1);
+  ASSERT_EQ(2, results.size());
+  EXPECT_EQ(argue::PARSE_FINISHED, results[0].result);
+  EXPECT_EQ(argue::PARSE_EXCEPTION, results[1].result);
+  EXPECT_EQ(argue::Exception::INPUT_ERROR, results[1].error.type);
+  const std::string& message = results[1].error.message;
+  EXPECT_NE(std::string::npos, message.find("Count is too large")) << message;
+  EXPECT_EQ(parser.get_usage_string(), results[1].error.usage);
+}
+
+TEST(ChoicesTest, SetsAreMovedInAndShared) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  std::vector<std::string> ids;
+  for (size_t idx = 0; idx < 10000; ++idx) {
+    ids.push_back(fmt::format("id{:05d}", idx));
+  }
+  const std::string* storage = ids.data();
+
+  std::string src;
+  std::string dst;
+  std::vector<std::string> extra;
+  using namespace argue::keywords;  // NOLINT
+  std::shared_ptr<const argue::ChoiceSet<std::string>> id_set =
+      argue::make_choices(std::move(ids));
+  EXPECT_EQ(storage, id_set->values().data());
+  parser.add_argument("-s", "--src", dest = &src, choices = id_set);
+  parser.add_argument("-d", "--dst", dest = &dst, choices = id_set);
+  parser.add_argument("extra", nargs = "*", dest = &extra,
+                      choices = std::vector<std::string>{"x", "y"});
+  parser.freeze();
+
+  argue::ParseError error{};
+  EXPECT_EQ(argue::PARSE_FINISHED,
+            parser.try_parse_args({"-s", "id00042", "-d", "id09999", "x", "y"},
+                                  &error, &logout))
+      << error.message;
+  EXPECT_EQ("id00042", src);
+  EXPECT_EQ("id09999", dst);
+  EXPECT_EQ(std::vector<std::string>({"x", "y"}), extra);
+
+  error = {};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"-s", "id10000"}, &error, &logout));
+  EXPECT_EQ(argue::Exception::INPUT_ERROR, error.type);
+  EXPECT_EQ(1, error.token_index);
+
+  error = {};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"x", "z"}, &error, &logout));
+  EXPECT_EQ(1, error.token_index);
+}
+
+enum class Shape { CIRCLE, SQUARE, TRIANGLE };
+
+namespace argue {
+template <>
+struct EnumTraits<Shape> {
+  static EnumTable<Shape> table() {
+    static constexpr EnumEntry<Shape> kEntries[] = {
+        {"circle", Shape::CIRCLE},
+        {"square", Shape::SQUARE},
+        {"triangle", Shape::TRIANGLE},
+        {"tri", Shape::TRIANGLE},
+    };
+    return kEntries;
+  }
+};
+}  // namespace argue
+
+TEST(EnumTest, NamesAreParsedDirectlyIntoEnums) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  Shape shape = Shape::CIRCLE;
+  Shape outline = Shape::CIRCLE;
+  std::vector<Shape> shapes;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-s", "--shape", dest = &shape, default_ = Shape::SQUARE,
+                      help = "the shape");
+  parser.add_argument("-o", "--outline", dest = &outline,
+                      choices = {Shape::SQUARE, Shape::TRIANGLE});
+  parser.add_argument("shapes", nargs = "*", dest = &shapes);
+  parser.freeze();
+
+  argue::ParseError error{};
+  EXPECT_EQ(argue::PARSE_FINISHED,
+            parser.try_parse_args({"tri", "circle", "-o", "square"}, &error,
+                                  &logout))
+      << error.message;
+  EXPECT_EQ(Shape::SQUARE, shape);
+  EXPECT_EQ(Shape::SQUARE, outline);
+  EXPECT_EQ(std::vector<Shape>({Shape::TRIANGLE, Shape::CIRCLE}), shapes);
+
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"--shape", "hexagon"}, &error, &logout));
+  EXPECT_EQ(1, error.token_index);
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"-o", "circle"}, &error, &logout));
+  EXPECT_EQ(1, error.token_index);
+  EXPECT_NE(std::string::npos,
+            error.message.find("choose from 'square, triangle'"))
+      << error.message;
+
+  // Help lists the names from the table, or the choices if they are given
+  std::stringstream help;
+  parser.print_help(&help);
+  EXPECT_NE(std::string::npos,
+            help.str().find("choices=[circle, square, triangle, tri]"))
+      << help.str();
+  EXPECT_NE(std::string::npos, help.str().find("choices=[square, triangle]"))
+      << help.str();
+}
+
+TEST(ResponseFileTest, ArgumentsAreReadFromFiles) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser,
+              {.add_help = false, .name = "prog", .response_files = true});
+
+  int jobs = 0;
+  std::string output;
+  std::vector<std::string> files;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-j", "--jobs", dest = &jobs);
+  parser.add_argument("-o", "--output", dest = &output);
+  parser.add_argument("files", nargs = "*", dest = &files);
+
+  std::string flags_path = ::testing::TempDir() + "argue_flags.rsp";
+  std::ofstream{flags_path} << "--output 'out dir/result.txt'\n";
+  std::string files_path = ::testing::TempDir() + "argue_files.rsp";
+  {
+    std::ofstream outfile{files_path};
+    outfile << "@" << flags_path << "\n";
+    for (size_t idx = 0; idx < 100000; ++idx) {
+      outfile << "input_" << idx << ".txt\n";
+    }
+  }
+
+  std::string files_arg = "@" + files_path;
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            parser.parse_args({"-j", "4", files_arg}, &logout))
+      << logout.str();
+  EXPECT_EQ(4, jobs);
+  EXPECT_EQ("out dir/result.txt", output);
+  ASSERT_EQ(100000, files.size());
+  EXPECT_EQ("input_0.txt", files.front());
+  EXPECT_EQ("input_99999.txt", files.back());
+
+  // Errors are reported at the index of the argument within the expansion
+  argue::ParseError error{};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({files_arg, "--jobs", "x"}, &error));
+  EXPECT_EQ(100003, error.token_index);
+}
+
+TEST(ResponseFileTest, ShortFlagsOutliveTheirValues) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser,
+              {.add_help = false, .name = "prog", .response_files = true});
+
+  std::vector<std::string> pair;
+  bool flag = false;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-a", nargs = 2, dest = &pair);
+  parser.add_argument("-b", action = "store_true", dest = &flag);
+
+  // NOTE(josh): quoted arguments are unquoted into a buffer of the stream
+  // which is reused two tokens later, i.e. by the second value of `-a`.
+  std::string flags_path = ::testing::TempDir() + "argue_cluster.rsp";
+  std::ofstream{flags_path} << "\"-ab\" \"ppp\" \"qqq\"\n";
+
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            parser.parse_args({"@" + flags_path}, &logout))
+      << logout.str();
+  EXPECT_EQ(std::vector<std::string>({"ppp", "qqq"}), pair);
+  EXPECT_TRUE(flag);
+}
+
+TEST(CallbackTest, ValuesAreDeliveredAsTheyAreParsed) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  std::vector<int> seen;
+  int num_seen_at_flag = -1;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("values", nargs = "*",
+                      dest = argue::each<int>([&seen](int value) {
+                        seen.push_back(value);
+                      }));
+  auto spec = parser.add_argument<int>("-f", "--flag");
+  spec.dest = argue::each<int>([&](int) { num_seen_at_flag = seen.size(); });
+
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            parser.parse_args({"1", "2", "3", "-f", "0"}, &logout))
+      << logout.str();
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), seen);
+  EXPECT_EQ(3, num_seen_at_flag);
+
+  // Values before an invalid one have already been delivered
+  seen.clear();
+  argue::ParseError error{};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"4", "5", "x", "6"}, &error));
+  EXPECT_EQ(2, error.token_index);
+  EXPECT_EQ(std::vector<int>({4, 5}), seen);
+}
+
+TEST(CallbackTest, FlagsMayBeDeliveredToCallbacks) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  std::vector<std::string> seen;
+  parser.add_argument<bool>(
+      "-v", "--verbose",
+      {.action = "store_true", .dest = argue::each<bool>([&seen](bool value) {
+         seen.push_back(fmt::format("verbose={}", value));
+       })});
+  auto spec = parser.add_argument<bool>("-q", "--quiet",
+                                        {.action = "store_true"});
+  spec.dest = argue::each<bool>([&seen](bool value) {
+    seen.push_back(fmt::format("quiet={}", value));
+  });
+
+  // The default of the flag which isn't given is delivered last
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args({"-q"}, &logout))
+      << logout.str();
+  EXPECT_EQ(std::vector<std::string>({"quiet=true", "verbose=false"}), seen);
+}
+
+TEST(CallbackTest, DefaultsAreOnlyDeliveredIfNoValueIsGiven) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  std::vector<int> jobs;
+  std::vector<std::string> files;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-j", "--jobs", default_ = 4,
+                      dest = argue::each<int>([&jobs](int value) {
+                        jobs.push_back(value);
+                      }));
+  parser.add_argument(
+      "file", nargs = "?", default_ = std::string("a"),
+      dest = argue::each<std::string>(
+          [&files](std::string value) { files.push_back(value); }));
+
+  ASSERT_EQ(argue::PARSE_FINISHED,
+            parser.parse_args({"-j", "8", "c"}, &logout))
+      << logout.str();
+  EXPECT_EQ(std::vector<int>({8}), jobs);
+  EXPECT_EQ(std::vector<std::string>({"c"}), files);
+
+  jobs.clear();
+  files.clear();
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args({}, &logout))
+      << logout.str();
+  EXPECT_EQ(std::vector<int>({4}), jobs);
+  EXPECT_EQ(std::vector<std::string>({"a"}), files);
+
+  // Nothing is delivered for a command line which fails to parse
+  jobs.clear();
+  files.clear();
+  argue::ParseError error{};
+  EXPECT_EQ(argue::PARSE_EXCEPTION,
+            parser.try_parse_args({"--bogus"}, &error));
+  EXPECT_EQ(std::vector<int>(), jobs);
+  EXPECT_EQ(std::vector<std::string>(), files);
+}
+
+TEST(ReserveTest, ListDestinationsAreSizedOnce) {
+  std::stringstream logout;
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  std::vector<int> values;
+  std::vector<int> pair;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("values", nargs = "*", dest = &values);
+  parser.add_argument("-p", "--pair", nargs = 2, dest = &pair);
+
+  std::vector<std::string> storage;
+  for (int idx = 0; idx < 1000; ++idx) {
+    storage.emplace_back(std::to_string(idx));
+  }
+  storage.emplace_back("--pair");
+  storage.emplace_back("1");
+  storage.emplace_back("2");
+  std::vector<argue::StringPiece> tokens{storage.begin(), storage.end()};
+  argue::TokenStream args{tokens.data(), tokens.data() + tokens.size()};
+
+  ASSERT_EQ(argue::PARSE_FINISHED, parser.parse_args(&args, &logout))
+      << logout.str();
+  EXPECT_EQ(1000, values.size());
+  EXPECT_EQ(1000, values.capacity());
+  EXPECT_EQ(2, pair.capacity());
+}
+
+TEST(HelpTest, RenderingIsCachedUntilModified) {
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = true, .name = "prog"});
+
+  int jobs = 0;
+  int count = 0;
+  using namespace argue::keywords;  // NOLINT
+  parser.add_argument("-j", "--jobs", dest = &jobs,
+                      help = "number of jobs to run at once, which is a "
+                             "long enough description to be wrapped");
+  parser.freeze();
+
+  std::stringstream usage;
+  parser.print_usage(&usage);
+  EXPECT_EQ("prog [-h/--help] [-j/--jobs]\n", usage.str());
+  EXPECT_EQ(usage.str(), parser.get_usage_string());
+
+  std::stringstream first;
+  std::stringstream second;
+  parser.print_help(&first);
+  parser.print_help(&second);
+  EXPECT_EQ(first.str(), second.str());
+  EXPECT_NE(std::string::npos,
+            first.str().find("-j  --jobs          number of jobs to run at "
+                             "once, which is a long enough\n"
+                             "                    description to be wrapped"))
+      << first.str();
+
+  // Help with other columns is rendered for the call, and the cached help is
+  // unchanged
+  std::stringstream narrow;
+  parser.print_help(&narrow, {{4, 16, 20}, 0});
+  EXPECT_NE(first.str(), narrow.str());
+  std::stringstream third;
+  parser.print_help(&third);
+  EXPECT_EQ(first.str(), third.str());
+
+  // Adding an argument discards the cache
+  parser.add_argument("-c", "--count", dest = &count);
+  EXPECT_EQ("prog [-h/--help] [-j/--jobs] [-c/--count]\n",
+            parser.get_usage_string());
+  parser.freeze();
+  EXPECT_EQ("prog [-h/--help] [-j/--jobs] [-c/--count]\n",
+            parser.get_usage_string());
+  std::stringstream fourth;
+  parser.print_help(&fourth);
+  EXPECT_NE(std::string::npos, fourth.str().find("--count")) << fourth.str();
+}
+
+// A parsed JSON document, just enough of one to check the structure of the
+// JSON help.
+struct JsonValue {
+  enum Type { NONE, BOOLEAN, NUMBER, STRING, LIST, OBJECT };
+  Type type = NONE;
+  std::string string;  //< the value of a string, or text of a number/boolean
+  std::vector<JsonValue> list;
+  std::vector<std::pair<std::string, JsonValue>> object;
+
+  // Return the member named `key`, or an empty value if there isn't one
+  const JsonValue& operator[](const std::string& key) const {
+    static const JsonValue kNone;
+    for (const auto& pair : object) {
+      if (pair.first == key) {
+        return pair.second;
+      }
+    }
+    return kNone;
+  }
+};
+
+// Parse the JSON value at the start of `*str`, advancing past it. Return false
+// if it is malformed.
+bool ParseJson(argue::StringPiece* str, JsonValue* value) {
+  auto skip_space = [str]() {
+    while (!str->empty() && std::isspace((*str)[0])) {
+      *str = str->substr(1);
+    }
+  };
+  auto consume = [str, &skip_space](char expect) {
+    skip_space();
+    if (str->empty() || (*str)[0] != expect) {
+      return false;
+    }
+    *str = str->substr(1);
+    return true;
+  };
+  auto parse_string = [str](std::string* out) {
+    *str = str->substr(1);
+    while (!str->empty() && (*str)[0] != '"') {
+      if ((*str)[0] == '\\') {
+        if (str->size() < 2) {
+          return false;
+        }
+        *str = str->substr(1);
+      }
+      out->push_back((*str)[0]);
+      *str = str->substr(1);
+    }
+    if (str->empty()) {
+      return false;
+    }
+    *str = str->substr(1);
+    return true;
+  };
+
+  skip_space();
+  if (str->empty()) {
+    return false;
+  }
+  switch ((*str)[0]) {
+    case '"':
+      value->type = JsonValue::STRING;
+      return parse_string(&value->string);
+    case '[':
+      value->type = JsonValue::LIST;
+      *str = str->substr(1);
+      if (consume(']')) {
+        return true;
+      }
+      do {
+        value->list.emplace_back();
+        if (!ParseJson(str, &value->list.back())) {
+          return false;
+        }
+      } while (consume(','));
+      return consume(']');
+    case '{':
+      value->type = JsonValue::OBJECT;
+      *str = str->substr(1);
+      if (consume('}')) {
+        return true;
+      }
+      do {
+        value->object.emplace_back();
+        skip_space();
+        if (str->empty() || (*str)[0] != '"' ||
+            !parse_string(&value->object.back().first) || !consume(':') ||
+            !ParseJson(str, &value->object.back().second)) {
+          return false;
+        }
+      } while (consume(','));
+      return consume('}');
+    default:
+      value->type = JsonValue::NUMBER;
+      while (!str->empty() && std::strchr("-+.eE0123456789truefalsn",
+                                           (*str)[0]) != nullptr) {
+        value->string.push_back((*str)[0]);
+        *str = str->substr(1);
+      }
+      if (value->string == "true" || value->string == "false") {
+        value->type = JsonValue::BOOLEAN;
+      }
+      return !value->string.empty();
+  }
+}
+
+// Parse `str`, which must be exactly one JSON document
+bool ParseJson(const std::string& str, JsonValue* value) {
+  argue::StringPiece remainder(str);
+  if (!ParseJson(&remainder, value)) {
+    return false;
+  }
+  while (!remainder.empty() && std::isspace(remainder[0])) {
+    remainder = remainder.substr(1);
+  }
+  return remainder.empty();
+}
+
+TEST(HelpTest, JsonHelpIsOneDocumentForTheTree) {
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  std::string command;
+  std::string subcommand;
+  auto subparsers = parser.add_subparsers("command", &command);
+  for (int idx = 0; idx < 600; ++idx) {
+    auto sub = subparsers->add_parser(fmt::format("command-{:03d}", idx),
+                                      {.help = "a command in a large tree"});
+    if (idx == 7) {
+      auto nested = sub->add_subparsers("subcommand", &subcommand);
+      nested->add_parser("nested-a", {.help = "a nested \"command\""});
+      nested->add_parser("nested-b", {.help = "another nested command"});
+    }
+  }
+  parser.freeze();
+
+  argue::Parser::HelpOptions opts{argue::kDefaultColumns, 0,
+                                  argue::Parser::HelpOptions::FORMAT_JSON,
+                                  false};
+  std::stringstream single;
+  parser.print_help(&single, opts);
+  JsonValue doc;
+  ASSERT_TRUE(ParseJson(single.str(), &doc)) << single.str();
+  ASSERT_EQ(JsonValue::LIST, doc.type);
+  ASSERT_EQ(1, doc.list.size());
+  EXPECT_EQ("prog", doc.list[0]["metadata"]["name"].string);
+  EXPECT_EQ(600, doc.list[0]["subcommands"].list.size());
+
+  // The recursive dump spans many blocks of the output buffer, and is still
+  // a single list with one element per parser, in tree order. Each
+  // subcommand refers to the element of its parser by id.
+  opts.recurse = true;
+  std::stringstream tree;
+  parser.print_help(&tree, opts);
+  EXPECT_GT(tree.str().size(), 64 * 1024);
+  doc = JsonValue();
+  ASSERT_TRUE(ParseJson(tree.str(), &doc));
+  ASSERT_EQ(JsonValue::LIST, doc.type);
+  ASSERT_EQ(603, doc.list.size());
+
+  std::map<std::string, size_t> index_of_id;
+  for (size_t idx = 0; idx < doc.list.size(); ++idx) {
+    const std::string& id = doc.list[idx]["metadata"]["id"].string;
+    ASSERT_FALSE(id.empty()) << idx;
+    EXPECT_TRUE(index_of_id.emplace(id, idx).second) << id;
+  }
+
+  // Every subcommand of a parser follows it in the list, at one greater
+  // depth, and subtrees are contiguous.
+  std::function<size_t(size_t, int)> check_subtree = [&](size_t idx,
+                                                         int depth) {
+    const JsonValue& help = doc.list[idx];
+    EXPECT_EQ(std::to_string(depth), help["metadata"]["subdepth"].string);
+    size_t next = idx + 1;
+    for (const JsonValue& sub : help["subcommands"].list) {
+      EXPECT_EQ(next, index_of_id[sub["id"].string]) << sub["name"].string;
+      next = check_subtree(next, depth + 1);
+    }
+    return next;
+  };
+  EXPECT_EQ(doc.list.size(), check_subtree(0, 0));
+
+  const JsonValue& nested = doc.list[index_of_id[doc.list[0]["subcommands"]
+                                                          .list[7]["id"]
+                                                          .string]];
+  ASSERT_EQ(2, nested["subcommands"].list.size());
+  EXPECT_EQ("nested-a", nested["subcommands"].list[0]["name"].string);
+  EXPECT_EQ("a nested \"command\"",
+            nested["subcommands"].list[0]["help"].string);
+  EXPECT_EQ("command-599", doc.list.back()["metadata"]["name"].string);
+}
+
+TEST(HelpTest, PrecomputedHelpIsPrintedAndExportRenders) {
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = true, .name = "prog"});
+
+  std::string command;
+  auto subparsers = parser.add_subparsers("command", &command);
+  subparsers->add_parser("sub", {.help = "a subcommand"});
+  parser.freeze();
+
+  static const argue::PrecomputedHelp kHelpText[] = {
+      {"prog", "precomputed prog\n", 17},
+      {"prog sub", "precomputed sub\n", 16},
+  };
+  argue::register_help_text(kHelpText, kHelpText + 2);
+
+  std::stringstream help;
+  parser.print_help(&help);
+  EXPECT_EQ("precomputed prog\n", help.str());
+
+  // The export always renders the help, and holds every parser of the tree
+  argue::Parser::HelpOptions opts{argue::kDefaultColumns, 0,
+                                  argue::Parser::HelpOptions::FORMAT_EXPORT,
+                                  false};
+  std::stringstream exported;
+  parser.print_help(&exported, opts);
+  argue::register_help_text(nullptr, nullptr);
+  EXPECT_EQ(std::string::npos, exported.str().find("precomputed"))
+      << exported.str();
+  EXPECT_NE(std::string::npos, exported.str().find("\"help_text\""))
+      << exported.str();
+  EXPECT_NE(std::string::npos, exported.str().find("prog sub [-h/--help]"))
+      << exported.str();
+}
+
+TEST(CompletionTest, SpecDescribesTheWholeTree) {
+  argue::Parser parser;
+  ResetParser(&parser, {.add_help = false, .name = "prog"});
+
+  using namespace argue::keywords;  // NOLINT
+  bool verbose = false;
+  int jobs = 0;
+  std::vector<std::string> files;
+  std::string command;
+  std::string target;
+  parser.add_argument("-v", "--verbose", &verbose, {.action = "store_true"});
+  parser.add_argument("-j", "--jobs", dest = &jobs, choices = {1, 2, 4});
+  parser.add_argument("--files", dest = &files, nargs = "+");
+  auto subparsers = parser.add_subparsers("command", &command);
+  subparsers->add_lazy_parser(
+      "push", {.help = "", .aliases = {"p"}}, [&](argue::Parser* sub) {
+        sub->add_argument("target", dest = &target,
+                          choices = std::vector<std::string>{"origin", "b"});
+      });
+  parser.freeze();
+
+  std::stringstream spec;
+  std::streambuf* stdout_buf = std::cout.rdbuf(spec.rdbuf());
+  parser.write_completion_spec();
+  std::cout.rdbuf(stdout_buf);
+
+  // Lazy subparsers are built so that their arguments are in the spec
+  EXPECT_EQ(
+      "argue-completion-spec\t1\n"
+      "parser\t0\tprog\n"
+      "flag\t0\t0\t0\t-v\t--verbose\t\n"
+      "flag\t0\t1\t1\t-j\t--jobs\t1\t2\t4\t\n"
+      "flag\t0\t2\t+\t-\t--files\t\n"
+      "short\t0\t1\t0\n"
+      "long\t0\t2\t1\t0\n"
+      "positional\t0\t0\tcommand\tp\tpush\t\n"
+      "command\t0\t0\tpush\t1\n"
+      "command\t0\t0\tp\t1\n"
+      "parser\t1\tprog push\n"
+      "flag\t1\t0\t!\t-h\t--help\t\n"
+      "short\t1\t0\n"
+      "long\t1\t0\n"
+      "positional\t1\t0\t1\tb\torigin\t\n",
+      spec.str());
+}
+
+#if ARGUE_HAVE_ELF_NOTES
+// Count the argue capability notes, of the current spec version, in the note
+// segments of a loaded object
+static int count_capability_notes(struct dl_phdr_info* info, size_t size,
+                                  void* data) {
+  for (size_t idx = 0; idx < info->dlpi_phnum; ++idx) {
+    const ElfW(Phdr)& phdr = info->dlpi_phdr[idx];
+    if (phdr.p_type != PT_NOTE || phdr.p_align > 4) {
+      continue;
+    }
+    const char* cursor =
+        reinterpret_cast<const char*>(info->dlpi_addr + phdr.p_vaddr);
+    const char* end = cursor + phdr.p_memsz;
+    while (cursor + sizeof(ElfW(Nhdr)) <= end) {
+      const ElfW(Nhdr)* nhdr = reinterpret_cast<const ElfW(Nhdr)*>(cursor);
+      const char* name = cursor + sizeof(ElfW(Nhdr));
+      const char* desc = name + (nhdr->n_namesz + 3) / 4 * 4;
+      if (nhdr->n_namesz == sizeof(argue::kElfNoteName) &&
+          std::strcmp(name, argue::kElfNoteName) == 0 &&
+          nhdr->n_type == argue::NOTE_CAPABILITY &&
+          nhdr->n_descsz == sizeof(argue::kCompletionSpecVersion) &&
+          std::strcmp(desc, argue::kCompletionSpecVersion) == 0) {
+        ++*static_cast<int*>(data);
+      }
+      cursor = desc + (nhdr->n_descsz + 3) / 4 * 4;
+    }
+  }
+  return 0;
+}
+
+TEST(CompletionTest, ProgramsCarryTheCapabilityNote) {
+  // NOTE(josh): the note is only linked in with the parser
+  argue::Parser parser;
+  parser.freeze();
+
+  int num_notes = 0;
+  dl_iterate_phdr(count_capability_notes, &num_notes);
+  EXPECT_EQ(1, num_notes);
+}
+#endif
@@ -162,3 +162,58 @@ TEST(AssertTest, MacroTest) {
   ARGUE_ASSERT(BUG, ReturnsTrue(1, 2, 3)) << "Unexpected!";
   ARGUE_ASSERT(BUG, TReturnsTrue<int, int, int>(1, 2, 3)) << "Unexpected!";
 }
+
+std::string CountedMessage(int* count) {
+  (*count)++;
+  return "Expensive message";
+}
+
+TEST(AssertTest, MessageIsOnlyEvaluatedOnFailure) {
+  int count = 0;
+  int evaluations = 0;
+  ARGUE_ASSERT(BUG, ++evaluations > 0) << CountedMessage(&count);
+  EXPECT_EQ(0, count);
+  EXPECT_EQ(1, evaluations);
+
+  evaluations = 0;
+  try {
+    ARGUE_ASSERT(BUG, ++evaluations < 0) << CountedMessage(&count);
+  } catch (const argue::Exception& ex) {
+    EXPECT_EQ("Expensive message", ex.message);
+  }
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(1, evaluations);
+
+  // The assertion is a complete statement, so an unbraced else binds to the
+  // enclosing if.
+  bool took_else = false;
+  if (count == 0)
+    ARGUE_ASSERT(BUG, false) << CountedMessage(&count);
+  else
+    took_else = true;
+  EXPECT_TRUE(took_else);
+}
+
+TEST(AssertTest, OnlyBugsCaptureStackTraceByDefault) {
+  try {
+    ARGUE_THROW(INPUT_ERROR) << "Hello!";
+  } catch (const argue::Exception& ex) {
+    EXPECT_TRUE(ex.stack_trace.empty());
+  }
+
+  argue::Exception::set_trace_policy(argue::Exception::TRACE_ALL);
+  try {
+    ARGUE_THROW(INPUT_ERROR) << "Hello!";
+  } catch (const argue::Exception& ex) {
+    EXPECT_FALSE(ex.stack_trace.empty());
+    EXPECT_NE(nullptr, ex.stack_trace.address(0));
+  }
+
+  argue::Exception::set_trace_policy(argue::Exception::TRACE_NONE);
+  try {
+    Foo();
+  } catch (const argue::Exception& ex) {
+    EXPECT_TRUE(ex.stack_trace.empty());
+  }
+  argue::Exception::set_trace_policy(argue::Exception::TRACE_BUGS);
+}
@@ -0,0 +1,319 @@
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include <elf.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "argue/argue.h"
+#include "argue/can_complete.h"
+#include "argue/elf_note.h"
+
+namespace cache = argue::can_complete;
+
+// A temporary directory, removed along with the files created in it
+class TempDir {
+ public:
+  TempDir() {
+    char path[] = "/tmp/argue-can-complete-XXXXXX";
+    EXPECT_NE(nullptr, mkdtemp(path));
+    path_ = path;
+  }
+
+  ~TempDir() {
+    for (auto iter = created_.rbegin(); iter != created_.rend(); ++iter) {
+      if (unlink(iter->c_str())) {
+        rmdir(iter->c_str());
+      }
+    }
+    rmdir(path_.c_str());
+  }
+
+  // Return the path of `name` in the directory, which is removed with it
+  std::string file(const std::string& name) {
+    created_.push_back(path_ + "/" + name);
+    return created_.back();
+  }
+
+ private:
+  std::string path_;
+  std::vector<std::string> created_;
+};
+
+// Sets an environment variable for its lifetime
+class ScopedEnv {
+ public:
+  ScopedEnv(const char* name, const char* value) : name_(name) {
+    const char* saved = getenv(name);
+    has_saved_ = (saved != nullptr);
+    saved_ = saved ? saved : "";
+    setenv(name, value, 1);
+  }
+
+  ~ScopedEnv() {
+    if (has_saved_) {
+      setenv(name_, saved_.c_str(), 1);
+    } else {
+      unsetenv(name_);
+    }
+  }
+
+ private:
+  const char* name_;
+  bool has_saved_;
+  std::string saved_;
+};
+
+TEST(CacheTest, DirectoryIsVersioned) {
+  ScopedEnv home{"HOME", "/home/user"};
+  {
+    ScopedEnv xdg_cache_home{"XDG_CACHE_HOME", "/xdg/cache"};
+    EXPECT_EQ("/xdg/cache/argue/can-complete/v2", cache::get_cache_dir());
+  }
+  {
+    ScopedEnv xdg_cache_home{"XDG_CACHE_HOME", ""};
+    EXPECT_EQ("/home/user/.cache/argue/can-complete/v2",
+              cache::get_cache_dir());
+  }
+}
+
+TEST(CacheTest, NameIsTheEscapedCanonicalPath) {
+  TempDir dir;
+  std::string target = dir.file("100%");
+  std::ofstream{target} << "#!/bin/sh\n";
+  std::string link = dir.file("link");
+  ASSERT_EQ(0, symlink(target.c_str(), link.c_str()));
+
+  // Both paths of the same file share the cached verdict
+  std::string name = cache::get_cache_name(target);
+  EXPECT_EQ(name, cache::get_cache_name(link));
+  EXPECT_EQ(std::string::npos, name.find('/'));
+  EXPECT_NE(std::string::npos, name.find("100%25"));
+
+  // Paths which only differ in where a '%' or '/' is don't collide
+  EXPECT_EQ("%2Fno%25%2Fsuch", cache::get_cache_name("/no%/such"));
+  EXPECT_EQ("%2Fno%2F%25such", cache::get_cache_name("/no/%such"));
+}
+
+TEST(CacheTest, KeyIdentifiesTheFile) {
+  struct stat statbuf {};
+  statbuf.st_dev = 2049;
+  statbuf.st_ino = 1234;
+  statbuf.st_size = 5678;
+  statbuf.st_mtime = 1600000000;
+  EXPECT_EQ("2049 1234 5678 1600000000", cache::get_cache_key(statbuf));
+}
+
+TEST(CacheTest, VerdictsRoundTrip) {
+  TempDir dir;
+  dir.file("a");
+  dir.file("a/b");
+  std::string cache_path = dir.file("a/b/verdict");
+  int verdict = -1;
+  EXPECT_FALSE(cache::read_cached_verdict(cache_path, "1 2 3 4", &verdict));
+
+  // Missing parents are created
+  cache::write_cached_verdict(cache_path, "1 2 3 4", 0);
+  EXPECT_TRUE(cache::read_cached_verdict(cache_path, "1 2 3 4", &verdict));
+  EXPECT_EQ(0, verdict);
+
+  // A verdict for a different key, or a prefix of it, is not reused
+  verdict = -1;
+  EXPECT_FALSE(cache::read_cached_verdict(cache_path, "1 2 3 5", &verdict));
+  EXPECT_FALSE(cache::read_cached_verdict(cache_path, "1 2 3", &verdict));
+  EXPECT_EQ(-1, verdict);
+
+  cache::write_cached_verdict(cache_path, "1 2 3 5", 1);
+  EXPECT_TRUE(cache::read_cached_verdict(cache_path, "1 2 3 5", &verdict));
+  EXPECT_EQ(1, verdict);
+  EXPECT_FALSE(cache::read_cached_verdict(cache_path, "1 2 3 4", &verdict));
+
+  // Anything else in the file is ignored
+  for (const char* content : {"1 2 3 5 2\n", "1 2 3 5\n", "1 2 3 5 10\n", ""}) {
+    std::ofstream{cache_path} << content;
+    EXPECT_FALSE(cache::read_cached_verdict(cache_path, "1 2 3 5", &verdict))
+        << "'" << content << "'";
+  }
+}
+
+// Lay out one note, starting at an offset aligned to `align`
+std::string MakeNote(const std::string& name, uint32_t type,
+                     const std::string& desc, size_t align) {
+  auto pad = [align](std::string* note) {
+    note->resize((note->size() + align - 1) / align * align, '\0');
+  };
+  uint32_t header[3] = {static_cast<uint32_t>(name.size() + 1),
+                        static_cast<uint32_t>(desc.size() + 1), type};
+  std::string note(reinterpret_cast<const char*>(header), sizeof(header));
+  note.append(name.c_str(), name.size() + 1);
+  pad(&note);
+  note.append(desc.c_str(), desc.size() + 1);
+  pad(&note);
+  return note;
+}
+
+// Build a 64 bit ELF image, of the native byte order, holding `notes`. They
+// are described by a program header, or if `use_sections` by a section
+// header only (as in an object file).
+std::string MakeImage(const std::string& notes, size_t align,
+                      bool use_sections) {
+  const size_t kNotesOffset = 128;
+  Elf64_Ehdr ehdr{};
+  std::memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+  ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+#else
+  ehdr.e_ident[EI_DATA] = ELFDATA2MSB;
+#endif
+  ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr.e_type = use_sections ? ET_REL : ET_EXEC;
+  ehdr.e_ehsize = sizeof(ehdr);
+
+  std::string image(kNotesOffset, '\0');
+  image += notes;
+  if (use_sections) {
+    image.resize((image.size() + 7) / 8 * 8, '\0');
+    ehdr.e_shoff = image.size();
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = 2;
+    Elf64_Shdr shdrs[2]{};
+    shdrs[1].sh_type = SHT_NOTE;
+    shdrs[1].sh_offset = kNotesOffset;
+    shdrs[1].sh_size = notes.size();
+    shdrs[1].sh_addralign = align;
+    image.append(reinterpret_cast<const char*>(shdrs), sizeof(shdrs));
+  } else {
+    ehdr.e_phoff = sizeof(ehdr);
+    ehdr.e_phentsize = sizeof(Elf64_Phdr);
+    ehdr.e_phnum = 1;
+    Elf64_Phdr phdr{};
+    phdr.p_type = PT_NOTE;
+    phdr.p_offset = kNotesOffset;
+    phdr.p_filesz = notes.size();
+    phdr.p_align = align;
+    std::memcpy(&image[ehdr.e_phoff], &phdr, sizeof(phdr));
+  }
+  std::memcpy(&image[0], &ehdr, sizeof(ehdr));
+  return image;
+}
+
+const char kSpec[] = "argue-completion-spec\t1\nparser\t0\tprog\n";
+
+TEST(NotesTest, FindsNotesAlignedToFourOrEightBytes) {
+  for (size_t align : {4, 8}) {
+    // NOTE(josh): the descriptor of an argue note (whose name is six bytes
+    // with the null) starts 20 bytes into the note when aligned to four, but
+    // 24 when aligned to eight.
+    std::string notes = MakeNote("GNU", 5, "property", align) +
+                        MakeNote("argue", argue::NOTE_CAPABILITY, "1", align) +
+                        MakeNote("argue", argue::NOTE_COMPLETION_SPEC, kSpec,
+                                 align);
+    std::string image = MakeImage(notes, align, false);
+    cache::ArgueNotes found{};
+    ASSERT_TRUE(cache::find_argue_notes(image.data(), image.size(), &found));
+    EXPECT_TRUE(found.found) << align;
+    EXPECT_EQ("1", found.spec_version) << align;
+    EXPECT_EQ(kSpec, found.completion_spec) << align;
+    EXPECT_TRUE(cache::has_supported_spec(found));
+  }
+}
+
+TEST(NotesTest, FallsBackToSectionHeaders) {
+  std::string notes = MakeNote("argue", argue::NOTE_CAPABILITY, "1", 4);
+  std::string image = MakeImage(notes, 4, true);
+  cache::ArgueNotes found{};
+  ASSERT_TRUE(cache::find_argue_notes(image.data(), image.size(), &found));
+  EXPECT_TRUE(found.found);
+  EXPECT_EQ("1", found.spec_version);
+  EXPECT_FALSE(cache::has_supported_spec(found));
+
+  // Notes of other owners don't count
+  notes = MakeNote("argument", argue::NOTE_CAPABILITY, "1", 4);
+  image = MakeImage(notes, 4, true);
+  found = cache::ArgueNotes{};
+  ASSERT_TRUE(cache::find_argue_notes(image.data(), image.size(), &found));
+  EXPECT_FALSE(found.found);
+}
+
+TEST(NotesTest, IgnoresAnythingOutOfBounds) {
+  std::string notes = MakeNote("argue", argue::NOTE_CAPABILITY, "1", 4) +
+                      MakeNote("argue", argue::NOTE_COMPLETION_SPEC, kSpec, 4);
+  for (bool use_sections : {false, true}) {
+    std::string image = MakeImage(notes, 4, use_sections);
+    // NOTE(josh): copied so that reading past the end is caught by sanitizers
+    for (size_t size = 0; size < image.size(); ++size) {
+      std::vector<char> truncated(image.begin(), image.begin() + size);
+      cache::ArgueNotes found{};
+      cache::find_argue_notes(truncated.data(), size, &found);
+      EXPECT_FALSE(found.found) << size;
+    }
+  }
+
+  // Sizes in a note header which overrun the notes
+  for (uint32_t namesz : {6u, 0xfffffff0u, 0xffffffffu}) {
+    for (uint32_t descsz : {2u, 0xfffffff0u, 0xffffffffu}) {
+      if (namesz == 6 && descsz == 2) {
+        continue;
+      }
+      std::string bad = MakeNote("argue", argue::NOTE_CAPABILITY, "1", 4);
+      std::memcpy(&bad[0], &namesz, sizeof(namesz));
+      std::memcpy(&bad[4], &descsz, sizeof(descsz));
+      std::string image = MakeImage(bad, 4, false);
+      cache::ArgueNotes found{};
+      cache::read_notes(image.data(), image.size(), 128, bad.size(), 4,
+                        &found);
+      EXPECT_FALSE(found.found) << namesz << ", " << descsz;
+    }
+  }
+
+  // Not an ELF image, or of a class we don't know
+  std::string image = MakeImage(notes, 4, false);
+  cache::ArgueNotes found{};
+  EXPECT_FALSE(cache::find_argue_notes(notes.data(), notes.size(), &found));
+  image[EI_CLASS] = ELFCLASSNONE;
+  EXPECT_FALSE(cache::find_argue_notes(image.data(), image.size(), &found));
+  EXPECT_FALSE(found.found);
+}
+
+TEST(NotesTest, RejectsSpecsOfAnotherVersion) {
+  cache::ArgueNotes found{};
+  found.found = true;
+  found.completion_spec = kSpec;
+  EXPECT_TRUE(cache::has_supported_spec(found));
+  found.spec_version = "2";
+  EXPECT_FALSE(cache::has_supported_spec(found));
+  found.spec_version = "1";
+  found.completion_spec = "argue-completion-spec\t2\nparser\t0\tprog\n";
+  EXPECT_FALSE(cache::has_supported_spec(found));
+}
+
+TEST(NotesTest, FindsTheCapabilityNoteOfThisProgram) {
+  // NOTE(josh): the note is only linked in with the parser
+  argue::Parser parser;
+  parser.freeze();
+
+  std::ifstream infile{"/proc/self/exe", std::ios::binary};
+  ASSERT_TRUE(infile.good());
+  std::string image{std::istreambuf_iterator<char>(infile),
+                    std::istreambuf_iterator<char>()};
+
+  cache::ArgueNotes found{};
+  ASSERT_TRUE(cache::find_argue_notes(image.data(), image.size(), &found));
+  EXPECT_TRUE(found.found);
+  EXPECT_EQ(argue::kCompletionSpecVersion, found.spec_version);
+  EXPECT_TRUE(found.completion_spec.empty());
+
+  // Truncated within the ELF header
+  found = cache::ArgueNotes{};
+  EXPECT_TRUE(cache::find_argue_notes(image.data(), sizeof(Elf64_Ehdr) - 1,
+                                      &found));
+  EXPECT_FALSE(found.found);
+}
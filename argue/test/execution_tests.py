@@ -10,12 +10,33 @@ from __future__ import unicode_literals
 import argparse
 import difflib
 import os
+import shutil
 import subprocess
 import sys
+import tempfile
 import unittest
 
 # NOTE(josh): eww globals, but unittest doesn't really make this easy
 EXE_PATH = None
+COMPLETION_EXE_PATHS = []
+PRERENDERED_EXE_PATH = None
+CAN_COMPLETE_PATH = None
+
+COMPLETION_SCRIPT = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), os.pardir,
+    "bash_completion.d", "argue-argcomplete")
+
+# Source the completion script, complete the words given as arguments the way
+# that bash would (the last one being the word under the cursor), and print
+# the completions one per line.
+COMPLETION_HARNESS = """\
+source "$1"
+shift
+COMP_WORDS=("$@")
+COMP_CWORD=$((${#COMP_WORDS[@]} - 1))
+_argue_autocomplete_global "$1" 2>/dev/null
+printf '%s\\n' "${COMPREPLY[@]}"
+"""
 
 
 EXPECT_HELP = """\
@@ -88,8 +109,100 @@ class TestExecution(unittest.TestCase):
                       "sum(1, 2, 3, 4) = 10\n")
 
 
+class TestCompletion(unittest.TestCase):
+  """
+  Complete command lines of the example programs through the bash completion
+  script, both from the cached completion spec (the default) and by executing
+  the program (ARGUE_COMPLETION_CACHE=0), and verify that they agree.
+  """
+
+  def setUp(self):
+    self.cache_dir = tempfile.mkdtemp(prefix="argue-cache-")
+
+  def tearDown(self):
+    shutil.rmtree(self.cache_dir)
+
+  def complete(self, exe_path, words, use_cache):
+    env = dict(os.environ)
+    env["XDG_CACHE_HOME"] = self.cache_dir
+    env.pop("ARGUE_COMPLETION_CACHE", None)
+    if not use_cache:
+      env["ARGUE_COMPLETION_CACHE"] = "0"
+    stdout = subprocess.check_output(
+        ["bash", "-c", COMPLETION_HARNESS, "bash", COMPLETION_SCRIPT,
+         exe_path] + words, env=env)
+    return sorted(line for line in stdout.decode("utf-8").split("\n")
+                  if line)
+
+  def assertSameCompletions(self, exe_path, words):
+    expect = self.complete(exe_path, words, use_cache=False)
+    actual = self.complete(exe_path, words, use_cache=True)
+    self.assertEqual(
+        expect, actual,
+        msg="Completions of {} {} differ".format(exe_path, words))
+    return expect
+
+  def test_spec_agrees_with_program(self):
+    for exe_path in [EXE_PATH] + COMPLETION_EXE_PATHS:
+      exe_path = os.path.abspath(exe_path)
+      first_words = self.assertSameCompletions(exe_path, [""])
+      self.assertTrue(first_words,
+                      msg="{} is not recognized as an argue program"
+                      .format(exe_path))
+      for words in (["-"], ["--"], ["--h"], ["x", ""]):
+        self.assertSameCompletions(exe_path, words)
+      for word in first_words:
+        for last in ("", "-", "--"):
+          self.assertSameCompletions(exe_path, [word, last])
+
+      # The completions above were answered from a cached spec
+      spec_dir = os.path.join(self.cache_dir, "argue", "completion")
+      self.assertTrue(os.path.isdir(spec_dir) and os.listdir(spec_dir),
+                      msg="No completion spec was cached for {}"
+                      .format(exe_path))
+
+  def test_readelf_detects_stripped_programs(self):
+    for tool in ("readelf", "strip"):
+      if not any(os.access(os.path.join(path, tool), os.X_OK)
+                 for path in os.environ.get("PATH", "").split(os.pathsep)):
+        self.skipTest("{} is not installed".format(tool))
+
+    stripped_path = os.path.join(self.cache_dir, "stripped")
+    subprocess.check_call(["strip", "-o", stripped_path, EXE_PATH])
+    check = 'source "$1"; SCRIPT_NAME=$2 __argue_hacky_can_complete'
+    for exe_path, expect in ((EXE_PATH, 0), (stripped_path, 0),
+                             (sys.executable, 1)):
+      returncode = subprocess.call(
+          ["bash", "-c", check, "bash", COMPLETION_SCRIPT, exe_path])
+      self.assertEqual(expect, returncode, msg=exe_path)
+
+  def test_print_spec_extracts_the_embedded_spec(self):
+    if CAN_COMPLETE_PATH is None or PRERENDERED_EXE_PATH is None:
+      self.skipTest("--can-complete-path and --prerendered-exe-path are "
+                    "required")
+
+    env = dict(os.environ)
+    env["_ARGUECOMPLETE"] = "spec"
+    expect = subprocess.check_output([PRERENDERED_EXE_PATH, "--help"],
+                                     env=env).decode("utf-8")
+    actual = subprocess.check_output(
+        [CAN_COMPLETE_PATH, "--print-spec", PRERENDERED_EXE_PATH])
+    self.assertTrue(expect.startswith("argue-completion-spec\t"))
+    self.assertEqual(expect, actual.decode("utf-8"))
+
+    # Programs without an embedded spec, and files which aren't programs
+    for path in (EXE_PATH, COMPLETION_SCRIPT):
+      proc = subprocess.Popen([CAN_COMPLETE_PATH, "--print-spec", path],
+                              stdout=subprocess.PIPE)
+      stdout, _ = proc.communicate()
+      self.assertEqual(1, proc.returncode, msg=path)
+      self.assertEqual(b"", stdout)
+
+
 def suite():
-  return unittest.TestLoader().loadTestsFromTestCase(TestExecution)
+  loader = unittest.TestLoader()
+  return unittest.TestSuite([loader.loadTestsFromTestCase(TestExecution),
+                             loader.loadTestsFromTestCase(TestCompletion)])
 
 
 class HelpAction(argparse._HelpAction):  # pylint:disable=W0212
@@ -116,10 +229,29 @@ def main():
   parser.add_argument("-h", "--help", action=HelpAction)
   parser.add_argument("--exe-path", required=True,
                       help="path to the argue-demo exe file")
+  parser.add_argument("--completion-exe-path", action="append", default=[],
+                      help="path to another argue program to check bash "
+                           "completion against. May be repeated.")
+  parser.add_argument("--prerendered-exe-path",
+                      help="path to an argue program built with the source "
+                           "generated by argue_help_artifacts()")
+  parser.add_argument("--can-complete-path",
+                      help="path to the argue-can-complete exe file")
   parser.add_argument("remainder", nargs=argparse.REMAINDER)
   args = parser.parse_args()
   global EXE_PATH  # pylint: disable=W0603
   EXE_PATH = args.exe_path
+  COMPLETION_EXE_PATHS.extend(args.completion_exe_path)
+  global PRERENDERED_EXE_PATH  # pylint: disable=W0603
+  PRERENDERED_EXE_PATH = args.prerendered_exe_path
+  if args.prerendered_exe_path:
+    COMPLETION_EXE_PATHS.append(args.prerendered_exe_path)
+  global CAN_COMPLETE_PATH  # pylint: disable=W0603
+  CAN_COMPLETE_PATH = args.can_complete_path
+  if args.can_complete_path:
+    os.environ["PATH"] = os.pathsep.join(
+        [os.path.dirname(os.path.abspath(args.can_complete_path)),
+         os.environ.get("PATH", "")])
 
   print("Using exe-path: {}".format(EXE_PATH))
   assert os.path.exists(EXE_PATH), \
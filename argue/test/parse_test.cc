@@ -1,4 +1,19 @@
 // Copyright 2018 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#if __cplusplus >= 201703L
+#include <charconv>
+#define ARGUE_HAVE_FROM_CHARS 1
+#else
+#define ARGUE_HAVE_FROM_CHARS 0
+#endif
+
 #include <gtest/gtest.h>
 
 #include "argue/argue.h"
@@ -67,23 +82,86 @@ TYPED_TEST(SignedParseTest, ParsesExamples) {
   EXPECT_PARSE("-123", -123);
 
   if (sizeof(TypeParam) > 0) {
-    EXPECT_PARSE("128", 128);
-    EXPECT_PARSE("-127", -127);
+    EXPECT_PARSE("127", 127);
+    EXPECT_PARSE("-128", -128);
   }
 
   if (sizeof(TypeParam) > 1) {
-    EXPECT_PARSE("32768", 32768);
-    EXPECT_PARSE("-32767", -32767);
+    EXPECT_PARSE("32767", 32767);
+    EXPECT_PARSE("-32768", -32768);
   }
 
   if (sizeof(TypeParam) > 2) {
-    EXPECT_PARSE("2147483648", 2147483648);
-    EXPECT_PARSE("-2147483647", -2147483647);
+    EXPECT_PARSE("2147483647", 2147483647);
+    EXPECT_PARSE("-2147483648", -2147483648LL);
   }
 
   if (sizeof(TypeParam) > 4) {
-    EXPECT_PARSE("9223372036854775808", 9223372036854775808UL);
-    EXPECT_PARSE("-9223372036854775807", -9223372036854775807LL);
+    EXPECT_PARSE("9223372036854775807", 9223372036854775807LL);
+    EXPECT_PARSE("-9223372036854775808",
+                 std::numeric_limits<int64_t>::min());
+  }
+}
+
+TYPED_TEST(UnsignedParseTest, RejectsOverflowAndMalformedInput) {
+  TypeParam value = 7;
+  std::string max = std::to_string(std::numeric_limits<TypeParam>::max());
+  EXPECT_EQ(0, argue::parse(max, &value));
+  EXPECT_EQ(std::numeric_limits<TypeParam>::max(), value);
+
+  // One more than the maximum
+  std::string over = max;
+  over.back() += 1;
+  EXPECT_NE(0, argue::parse(over, &value));
+  EXPECT_NE(0, argue::parse(max + "0", &value));
+  EXPECT_NE(0, argue::parse(std::string("99999999999999999999999"), &value));
+  EXPECT_EQ(std::numeric_limits<TypeParam>::max(), value);
+
+  for (const char* query : {"", "-1", "+1", "1a", " 1", "1 ", "0x", "0b2",
+                            "0o8", "_1", "1_", "1__0", "0x_f", "1.0"}) {
+    EXPECT_NE(0, argue::parse(argue::StringPiece(query), &value))
+        << "'" << query << "'";
+  }
+}
+
+TYPED_TEST(UnsignedParseTest, ParsesPrefixesAndSeparators) {
+  EXPECT_PARSE("0x7f", 127);
+  EXPECT_PARSE("0X7F", 127);
+  EXPECT_PARSE("0o177", 127);
+  EXPECT_PARSE("0b1111111", 127);
+  EXPECT_PARSE("0b0111_1111", 127);
+  EXPECT_PARSE("1_2_7", 127);
+  EXPECT_PARSE("1'27", 127);
+  EXPECT_PARSE("0127", 127);
+  EXPECT_PARSE("0", 0);
+  EXPECT_PARSE("0x0", 0);
+}
+
+TYPED_TEST(SignedParseTest, RejectsOverflowAndMalformedInput) {
+  typedef std::numeric_limits<TypeParam> Limits;
+  TypeParam value = 7;
+  std::string max = std::to_string(Limits::max());
+  std::string min = std::to_string(Limits::min());
+  EXPECT_EQ(0, argue::parse(min, &value));
+  EXPECT_EQ(Limits::min(), value);
+
+  std::string over = max;
+  over.back() += 1;
+  std::string under = min;
+  under.back() += 1;
+  EXPECT_NE(0, argue::parse(over, &value));
+  EXPECT_NE(0, argue::parse(under, &value));
+  EXPECT_NE(0, argue::parse(min + "0", &value));
+  EXPECT_EQ(Limits::min(), value);
+
+  for (const char* query : {"", "-", "--1", "+1", "-_1", "1-", "-0x"}) {
+    EXPECT_NE(0, argue::parse(argue::StringPiece(query), &value))
+        << "'" << query << "'";
+  }
+  EXPECT_PARSE("-0x80", -128);
+  EXPECT_PARSE("-0o1_0", -8);
+  if (sizeof(TypeParam) > 1) {
+    EXPECT_PARSE("-0b1_0000_0000", -256);
   }
 }
 
@@ -104,3 +182,249 @@ TYPED_TEST(FloatParseTest, ParsesExamples) {
   EXPECT_PARSE("987654.321", 987654.321);
   EXPECT_PARSE("-987654.321", -987654.321);
 }
+
+TYPED_TEST(FloatParseTest, ParsesExponentsAndSpecialValues) {
+  typedef std::numeric_limits<TypeParam> Limits;
+  EXPECT_PARSE("1e-9", 1e-9);
+  EXPECT_PARSE("-2.5E+3", -2.5e3);
+  EXPECT_PARSE(".5", 0.5);
+  EXPECT_PARSE("3.", 3);
+  EXPECT_PARSE("0.000001234e10", 12340);
+  EXPECT_PARSE("1e400", Limits::infinity());
+  EXPECT_PARSE("-1e400", -Limits::infinity());
+  EXPECT_PARSE("1e-400", 0);
+  EXPECT_PARSE("inf", Limits::infinity());
+  EXPECT_PARSE("-Infinity", -Limits::infinity());
+
+  TypeParam value = 0;
+  EXPECT_EQ(0, argue::parse(std::string("NaN"), &value));
+  EXPECT_TRUE(std::isnan(value));
+  EXPECT_EQ(0, argue::parse(std::string("-0"), &value));
+  EXPECT_EQ(0, value);
+  EXPECT_TRUE(std::signbit(value));
+
+  EXPECT_PARSE("123456789012345678901234567890", 1.2345678901234568e29);
+  EXPECT_PARSE("0.1000000000000000000000000000001", 0.1);
+}
+
+TYPED_TEST(FloatParseTest, RejectsMalformedInput) {
+  TypeParam value = 7;
+  for (const char* query : {"", "-", ".", "-.", "e5", "1e", "1e+", "1.2.3",
+                            "1,5", "+1", "--1", "1 ", "infinit", "nan1",
+                            "0x10", "1_000"}) {
+    EXPECT_NE(0, argue::parse(argue::StringPiece(query), &value))
+        << "'" << query << "'";
+  }
+  EXPECT_EQ(7, value);
+}
+
+// 2^53 + 1 lies exactly halfway between two doubles and rounds to the even
+// one. With the trailing digits the value is just above halfway, so it rounds
+// up. Those digits are beyond the 19 that are read into the mantissa.
+TEST(DoubleParseTest, RoundsHalfwayCasesCorrectly) {
+  double value = 0;
+  EXPECT_EQ(0, argue::parse(std::string("9007199254740993"), &value));
+  EXPECT_EQ(9007199254740992.0, value);
+  EXPECT_EQ(0, argue::parse(std::string("9007199254740995"), &value));
+  EXPECT_EQ(9007199254740996.0, value);
+  EXPECT_EQ(0, argue::parse(
+                   std::string("9007199254740993.000000000000000000001"),
+                   &value));
+  EXPECT_EQ(9007199254740994.0, value);
+
+  // Smallest subnormal, and the largest finite value
+  EXPECT_EQ(0, argue::parse(std::string("4.9406564584124654e-324"), &value));
+  EXPECT_EQ(std::numeric_limits<double>::denorm_min(), value);
+  EXPECT_EQ(0, argue::parse(std::string("1.7976931348623157e308"), &value));
+  EXPECT_EQ(std::numeric_limits<double>::max(), value);
+}
+
+// The midpoint between the largest finite value and the next power of two
+// rounds (to even) up to infinity, while anything below it rounds down to the
+// largest finite value. Both need more than 19 digits to tell apart.
+TEST(FloatRangeTest, RoundsToInfinityAtTheEdgeOfTheRange) {
+  // DBL_MAX + 1/2 ulp, i.e. 2^1024 - 2^970, in full
+  const std::string kDoubleMidpoint =
+      "179769313486231580793728971405303415079934132710037826936173778980444"
+      "968292764750946649017977587207096330286416692887910946555547851940402"
+      "630657488671505820681908902000708383676273854845817711531764475730270"
+      "069855571366959622842914819860834936475292719074168444365510704342711"
+      "559699508093042880177904174497792";
+  std::string below = kDoubleMidpoint;
+  below.back() = '1';
+
+  typedef std::numeric_limits<double> DoubleLimits;
+  double dvalue = 0;
+  EXPECT_EQ(0, argue::parse(kDoubleMidpoint, &dvalue));
+  EXPECT_EQ(DoubleLimits::infinity(), dvalue);
+  EXPECT_EQ(0, argue::parse("-" + kDoubleMidpoint, &dvalue));
+  EXPECT_EQ(-DoubleLimits::infinity(), dvalue);
+  EXPECT_EQ(0, argue::parse(below, &dvalue));
+  EXPECT_EQ(DoubleLimits::max(), dvalue);
+  EXPECT_EQ(0, argue::parse("-" + below, &dvalue));
+  EXPECT_EQ(-DoubleLimits::max(), dvalue);
+
+  // FLT_MAX + 1/2 ulp, i.e. 2^128 - 2^103
+  typedef std::numeric_limits<float> FloatLimits;
+  float fvalue = 0;
+  EXPECT_EQ(0, argue::parse(
+                   std::string("3.40282356779733661637539395458142568448e38"),
+                   &fvalue));
+  EXPECT_EQ(FloatLimits::infinity(), fvalue);
+  EXPECT_EQ(0, argue::parse(
+                   std::string("-3.40282356779733661637539395458142568448e38"),
+                   &fvalue));
+  EXPECT_EQ(-FloatLimits::infinity(), fvalue);
+  EXPECT_EQ(0, argue::parse(
+                   std::string("3.40282356779733661637539395458142568447e38"),
+                   &fvalue));
+  EXPECT_EQ(FloatLimits::max(), fvalue);
+}
+
+// Reference conversion of a decimal string
+inline float reference_parse_float(const std::string& query, float*) {
+  return std::strtof(query.c_str(), nullptr);
+}
+
+inline double reference_parse_float(const std::string& query, double*) {
+  return std::strtod(query.c_str(), nullptr);
+}
+
+template <typename T>
+class DifferentialFloatParseTest : public ::testing::Test {};
+TYPED_TEST_CASE(DifferentialFloatParseTest, FloatTypes);
+
+// Every finite value, printed with enough digits to identify it, parses back
+// to exactly the same value.
+TYPED_TEST(DifferentialFloatParseTest, RoundTripsPrintedValues) {
+  typedef std::numeric_limits<TypeParam> Limits;
+  std::mt19937_64 rng{1234};
+  char buffer[64];
+  for (size_t iter = 0; iter < 20000; ++iter) {
+    TypeParam expect = 0;
+    do {
+      uint64_t bits = rng();
+      std::memcpy(&expect, &bits, sizeof(expect));
+    } while (!std::isfinite(expect));
+
+    snprintf(buffer, sizeof(buffer), "%.*g", Limits::max_digits10,
+             static_cast<double>(expect));
+    TypeParam actual = 0;
+    EXPECT_EQ(0, argue::parse(std::string(buffer), &actual)) << buffer;
+    EXPECT_EQ(expect, actual) << buffer;
+  }
+}
+
+// Generate random decimal strings, with between one and forty significant
+// digits and exponents spanning the whole range of the type, and check that
+// parse agrees with the C library.
+TYPED_TEST(DifferentialFloatParseTest, AgreesWithReference) {
+  std::mt19937_64 rng{1234};
+  int max_exponent = std::numeric_limits<TypeParam>::max_exponent10 + 30;
+  for (size_t iter = 0; iter < 20000; ++iter) {
+    std::string query = rng() % 2 ? "-" : "";
+    size_t num_digits = 1 + rng() % 40;
+    size_t decimal_idx = rng() % (num_digits + 1);
+    for (size_t idx = 0; idx < num_digits; ++idx) {
+      if (idx == decimal_idx) {
+        query.push_back('.');
+      }
+      query.push_back(static_cast<char>('0' + rng() % 10));
+    }
+    if (rng() % 4) {
+      int exponent = static_cast<int>(rng() % (2 * max_exponent)) -
+                     max_exponent;
+      query += "e" + std::to_string(exponent);
+    }
+
+    TypeParam actual = 0;
+    TypeParam expect = reference_parse_float(query, &actual);
+    EXPECT_EQ(0, argue::parse(query, &actual)) << query;
+    EXPECT_EQ(expect, actual) << query;
+  }
+}
+
+// Reference conversion of the digits of an integer in the given radix, with
+// prefix and separators already removed. Returns false if the value is out of
+// range for T. This is `std::from_chars` when built as c++17 or later, and
+// `strtoll`/`strtoull` otherwise.
+#if ARGUE_HAVE_FROM_CHARS
+template <typename T>
+bool reference_parse(const std::string& digits, int radix, T* value) {
+  auto result =
+      std::from_chars(digits.data(), digits.data() + digits.size(), *value,
+                      radix);
+  EXPECT_NE(std::errc::invalid_argument, result.ec) << digits;
+  EXPECT_EQ(digits.data() + digits.size(), result.ptr) << digits;
+  return result.ec == std::errc();
+}
+#else
+template <typename T>
+bool reference_parse(const std::string& digits, int radix, T* value) {
+  typedef std::numeric_limits<T> Limits;
+  errno = 0;
+  if (Limits::is_signed) {
+    long long result = std::strtoll(digits.c_str(), nullptr, radix);
+    if (errno == ERANGE || result < Limits::min() || result > Limits::max()) {
+      return false;
+    }
+    *value = static_cast<T>(result);
+  } else {
+    unsigned long long result = std::strtoull(digits.c_str(), nullptr, radix);
+    if (errno == ERANGE || result > Limits::max()) {
+      return false;
+    }
+    *value = static_cast<T>(result);
+  }
+  return true;
+}
+#endif
+
+template <typename T>
+class DifferentialParseTest : public ::testing::Test {};
+typedef ::testing::Types<uint8_t, uint16_t, uint32_t, uint64_t, int8_t,
+                         int16_t, int32_t, int64_t>
+    IntegerTypes;
+TYPED_TEST_CASE(DifferentialParseTest, IntegerTypes);
+
+// Generate random, well formed, integer strings in each radix (some of them
+// out of range) and check that parse agrees with the reference conversion.
+TYPED_TEST(DifferentialParseTest, AgreesWithReference) {
+  const char* kDigits = "0123456789abcdef";
+  const int kRadices[] = {2, 8, 10, 16};
+  const char* kPrefixes[] = {"0b", "0o", "", "0x"};
+  std::mt19937_64 rng{1234};
+
+  for (size_t iter = 0; iter < 20000; ++iter) {
+    size_t radix_idx = rng() % 4;
+    int radix = kRadices[radix_idx];
+    bool negative = std::numeric_limits<TypeParam>::is_signed && rng() % 2;
+    // Up to a few digits more than the widest value in base 2
+    size_t num_digits = 1 + rng() % (66 * (radix == 2) + 24);
+
+    std::string digits = negative ? "-" : "";
+    std::string query = digits + kPrefixes[radix_idx];
+    for (size_t idx = 0; idx < num_digits; ++idx) {
+      char digit = kDigits[rng() % radix];
+      if (radix == 16 && rng() % 2) {
+        digit = static_cast<char>(std::toupper(digit));
+      }
+      if (idx > 0 && rng() % 8 == 0) {
+        query.push_back(rng() % 2 ? '_' : '\'');
+      }
+      digits.push_back(digit);
+      query.push_back(digit);
+    }
+
+    TypeParam expect = 0;
+    TypeParam actual = 0;
+    bool in_range = reference_parse(digits, radix, &expect);
+    int result = argue::parse(query, &actual);
+    if (in_range) {
+      EXPECT_EQ(0, result) << query;
+      EXPECT_EQ(expect, actual) << query;
+    } else {
+      EXPECT_NE(0, result) << query;
+    }
+  }
+}
@@ -1,4 +1,7 @@
 // Copyright 2018 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include <algorithm>
+#include <fstream>
+
 #include <gtest/gtest.h>
 
 #include "argue/argue.h"
@@ -15,3 +18,224 @@ TEST(ArgTypeTest, CorrectlyParsesExampleQueries) {
   EXPECT_EQ(argue::LONG_FLAG, argue::get_arg_type("--foo"));
   EXPECT_EQ(argue::POSITIONAL, argue::get_arg_type("foo"));
 }
+
+TEST(WrapTest, BreaksBetweenWords) {
+  EXPECT_EQ("", argue::wrap("", 10));
+  EXPECT_EQ("", argue::wrap(" \t\n ", 10));
+  EXPECT_EQ("one two\nthree four", argue::wrap("  one two\tthree\nfour ", 10));
+  EXPECT_EQ("verylongword\nx", argue::wrap("verylongword x", 10));
+  EXPECT_EQ("a  b", argue::wrap("a  b", 0));
+  EXPECT_EQ("", argue::repeat("-", 0));
+  EXPECT_EQ("-+-+-+", argue::repeat("-+", 3));
+}
+
+TEST(StringPieceTest, ViewsWithoutCopying) {
+  std::string storage = "--foo-bar";
+  argue::StringPiece piece{storage};
+  EXPECT_EQ(storage.data(), piece.data());
+  EXPECT_EQ(storage.size(), piece.size());
+  EXPECT_TRUE(piece.starts_with("--foo"));
+  EXPECT_FALSE(piece.starts_with("--bar"));
+  EXPECT_EQ(argue::StringPiece("foo-bar"), piece.substr(2));
+  EXPECT_EQ("foo", piece.substr(2, 3).to_string());
+  EXPECT_LT(argue::StringPiece("--foo"), piece);
+  EXPECT_LT(argue::StringPiece("--bar"), argue::StringPiece("--foo"));
+}
+
+TEST(TokenStreamTest, ConsumesInOrder) {
+  std::vector<argue::StringPiece> tokens = {"a", "b", "c"};
+  argue::TokenStream stream{tokens.data(), tokens.data() + tokens.size()};
+  ASSERT_EQ(3, stream.size());
+  EXPECT_EQ("a", stream.front().to_string());
+  stream.pop_front();
+  EXPECT_EQ(1, stream.index());
+  EXPECT_EQ("b", stream.front().to_string());
+  stream.pop_front();
+  stream.pop_front();
+  EXPECT_TRUE(stream.empty());
+  EXPECT_EQ(3, stream.index());
+}
+
+TEST(TokenStreamTest, ClassifiesPositionalRuns) {
+  std::vector<argue::StringPiece> tokens = {"a", "b", "-c", "--d", "e",
+                                            "f",  "g", "-",  "--"};
+  argue::TokenStream stream{tokens.data(), tokens.data() + tokens.size()};
+  EXPECT_EQ(argue::POSITIONAL, stream.front_type());
+  EXPECT_EQ(2, stream.positional_run());
+  stream.pop_front();
+  EXPECT_EQ(1, stream.positional_run());
+  stream.pop_front();
+  EXPECT_EQ(argue::SHORT_FLAG, stream.front_type());
+  EXPECT_EQ(0, stream.positional_run());
+  stream.pop_front();
+  EXPECT_EQ(argue::LONG_FLAG, stream.front_type());
+  stream.pop_front();
+  EXPECT_EQ(5, stream.positional_run());
+  // Later tokens take their type from the same pass
+  while (!stream.empty()) {
+    EXPECT_EQ(argue::POSITIONAL, stream.front_type()) << stream.front();
+    stream.pop_front();
+  }
+  EXPECT_EQ(0, stream.positional_run());
+}
+
+// Write `content` to a file in the test temporary directory and return its
+// path
+static std::string write_temp_file(const std::string& name,
+                                   const std::string& content) {
+  std::string path = ::testing::TempDir() + name;
+  std::ofstream outfile{path};
+  outfile << content;
+  return path;
+}
+
+TEST(ResponseFileTest, SplitsAndUnquotes) {
+  std::string path = write_temp_file(
+      "argue_split.rsp",
+      "  --foo bar\n\tbaz 'single quoted' \"double \\\"quoted\\\"\"\n"
+      "esc\\ aped mixed'x y'\"z\" 'unterminated");
+  std::unique_ptr<argue::ResponseFile> file = argue::ResponseFile::open(path);
+  ASSERT_TRUE(file);
+
+  std::vector<std::string> tokens;
+  argue::StringPiece token;
+  std::string scratch;
+  while (file->next(&token, &scratch)) {
+    tokens.emplace_back(token.to_string());
+  }
+  EXPECT_EQ(std::vector<std::string>({"--foo", "bar", "baz", "single quoted",
+                                      "double \"quoted\"", "esc aped",
+                                      "mixedx yz", "unterminated"}),
+            tokens);
+
+  EXPECT_FALSE(argue::ResponseFile::open(::testing::TempDir() +
+                                         "argue_does_not_exist.rsp"));
+  std::unique_ptr<argue::ResponseFile> empty =
+      argue::ResponseFile::open(write_temp_file("argue_empty.rsp", ""));
+  ASSERT_TRUE(empty);
+  EXPECT_FALSE(empty->next(&token, &scratch));
+}
+
+TEST(TokenStreamTest, ExpandsNestedResponseFiles) {
+  std::string inner = write_temp_file("argue_inner.rsp", "c 'd d'");
+  std::string empty = write_temp_file("argue_empty.rsp", "");
+  std::string outer =
+      write_temp_file("argue_outer.rsp", "b @" + inner + " @" + empty + " e");
+  std::string self = ::testing::TempDir() + "argue_self.rsp";
+  write_temp_file("argue_self.rsp", "@" + self);
+
+  std::string outer_arg = "@" + outer;
+  std::string self_arg = "@" + self;
+  std::vector<argue::StringPiece> tokens = {"a", outer_arg, "@missing", "f",
+                                            self_arg};
+  argue::TokenStream stream{tokens.data(), tokens.data() + tokens.size()};
+  stream.expand_response_files();
+
+  std::vector<std::string> consumed;
+  argue::StringPiece previous;
+  while (!stream.empty()) {
+    // The previous token must still be readable
+    if (consumed.size()) {
+      EXPECT_EQ(consumed.back(), previous.to_string());
+    }
+    consumed.emplace_back(stream.front().to_string());
+    previous = stream.front();
+    stream.pop_front();
+  }
+  EXPECT_EQ(std::vector<std::string>(
+                {"a", "b", "c", "d d", "e", "@missing", "f", self_arg}),
+            consumed);
+  EXPECT_EQ(consumed.size(), stream.index());
+}
+
+static argue::StringPiece identity_key(const std::string& str) {
+  return str;
+}
+
+TEST(PrefixRangeTest, FindsContiguousMatches) {
+  std::vector<std::string> sorted = {"--bar",      "--foo",   "--foo-bar",
+                                     "--foo-baz",  "--foot",  "--fop",
+                                     "--verbose"};
+  auto range = argue::prefix_range(sorted.begin(), sorted.end(), "--foo",
+                                   identity_key);
+  EXPECT_EQ(sorted.begin() + 1, range.first);
+  EXPECT_EQ(sorted.begin() + 5, range.second);
+
+  range = argue::prefix_range(sorted.begin(), sorted.end(), "--foo-",
+                              identity_key);
+  EXPECT_EQ(2, range.second - range.first);
+
+  range = argue::prefix_range(sorted.begin(), sorted.end(), "--x",
+                              identity_key);
+  EXPECT_EQ(range.first, range.second);
+
+  range = argue::prefix_range(sorted.begin(), sorted.end(), "", identity_key);
+  EXPECT_EQ(sorted.size(), range.second - range.first);
+}
+
+TEST(ChoiceSetTest, ValidatesAndCompletesLargeTables) {
+  std::vector<int> ids;
+  for (int idx = 0; idx < 50000; ++idx) {
+    ids.push_back(3 * idx);
+  }
+  argue::ChoiceSet<int> choices{std::move(ids)};
+  EXPECT_EQ(50000, choices.size());
+  EXPECT_TRUE(choices.contains(0));
+  EXPECT_TRUE(choices.contains(3 * 49999));
+  EXPECT_FALSE(choices.contains(1));
+  EXPECT_FALSE(choices.contains(-3));
+  EXPECT_FALSE(choices.contains(3 * 50000));
+  EXPECT_EQ(3, choices.values()[1]);
+
+  // Completion is by the string form of the value, in lexicographical order
+  std::vector<std::string> completions;
+  choices.for_each_completion("14999", [&](const argue::StringPiece& name) {
+    completions.push_back(name.to_string());
+  });
+  EXPECT_EQ(std::vector<std::string>({"149991", "149994", "149997"}),
+            completions);
+
+  completions.clear();
+  choices.for_each_completion("", [&](const argue::StringPiece& name) {
+    completions.push_back(name.to_string());
+  });
+  EXPECT_EQ(50000, completions.size());
+  EXPECT_TRUE(std::is_sorted(completions.begin(), completions.end()));
+}
+
+// A value type with equality but no std::hash specialization
+struct Color {
+  std::string name;
+  bool operator==(const Color& other) const {
+    return name == other.name;
+  }
+};
+
+std::ostream& operator<<(std::ostream& out, const Color& color) {
+  return out << color.name;
+}
+
+TEST(ChoiceSetTest, AcceptsTypesWithoutHash) {
+  argue::ChoiceSet<Color> choices{{"red"}, {"green"}, {"blue"}, {"green"}};
+  EXPECT_TRUE(choices.contains({"green"}));
+  EXPECT_FALSE(choices.contains({"purple"}));
+
+  std::vector<std::string> completions;
+  choices.for_each_completion("", [&](const argue::StringPiece& name) {
+    completions.push_back(name.to_string());
+  });
+  EXPECT_EQ(std::vector<std::string>({"blue", "green", "red"}), completions);
+}
+
+TEST(UtilTest, TypeIdComparesByType) {
+  EXPECT_FALSE(argue::TypeId());
+  EXPECT_TRUE(argue::type_id<Color>());
+  EXPECT_EQ(argue::TypeId(), argue::TypeId());
+  EXPECT_EQ(argue::type_id<Color>(), argue::type_id<Color>());
+  EXPECT_NE(argue::type_id<Color>(), argue::type_id<std::string>());
+  EXPECT_NE(argue::TypeId(), argue::type_id<Color>());
+
+  // Distinct type_info objects for the same type (as from two shared
+  // libraries) compare by the type they describe
+  EXPECT_EQ(argue::TypeId(typeid(Color)), argue::type_id<Color>());
+}
@@ -0,0 +1,164 @@
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include "argue/token_stream.h"
+
+namespace argue {
+
+// =============================================================================
+//                              Token Stream
+// =============================================================================
+
+const size_t TokenStream::kMaxResponseFileDepth;
+
+TokenStream::TokenStream()
+    : begin_(nullptr),
+      cursor_(nullptr),
+      end_(nullptr),
+      index_(0),
+      expand_(false),
+      front_type_(POSITIONAL) {}
+
+TokenStream::TokenStream(const StringPiece* begin, const StringPiece* end)
+    : begin_(begin),
+      cursor_(begin),
+      end_(end),
+      index_(0),
+      expand_(false),
+      front_type_(POSITIONAL) {
+  if (cursor_ != end_) {
+    front_ = *cursor_;
+    front_type_ = get_arg_type(front_);
+  }
+}
+
+TokenStream::~TokenStream() {}
+
+void TokenStream::expand_response_files() {
+  expand_ = true;
+  classes_.clear();
+  if (!empty()) {
+    settle();
+    front_type_ = get_arg_type(front_);
+  }
+}
+
+bool TokenStream::empty() const {
+  return cursor_ == end_ && files_.empty();
+}
+
+size_t TokenStream::size() const {
+  return end_ - cursor_;
+}
+
+const StringPiece& TokenStream::front() const {
+  return front_;
+}
+
+ArgType TokenStream::front_type() const {
+  return front_type_;
+}
+
+size_t TokenStream::positional_run() {
+  if (!files_.empty()) {
+    return front_type_ == POSITIONAL ? 1 : 0;
+  }
+  if (cursor_ == end_) {
+    return 0;
+  }
+  if (classes_.empty()) {
+    classify();
+  }
+  return classes_[cursor_ - begin_].run;
+}
+
+void TokenStream::classify() {
+  classes_.resize(end_ - begin_);
+  uint32_t run = 0;
+  for (size_t idx = classes_.size(); idx > 0; --idx) {
+    const StringPiece& token = begin_[idx - 1];
+    ArgType type = get_arg_type(token);
+    if (type == POSITIONAL && !is_response_file(token)) {
+      ++run;
+    } else {
+      run = 0;
+    }
+    classes_[idx - 1] = TokenClass{run, type};
+  }
+}
+
+ArgType TokenStream::classify_front() const {
+  if (files_.empty() && !classes_.empty()) {
+    return classes_[cursor_ - begin_].type;
+  }
+  return get_arg_type(front_);
+}
+
+void TokenStream::pop_front() {
+  ++index_;
+  if (!expand_) {
+    if (++cursor_ != end_) {
+      front_ = *cursor_;
+      front_type_ = classify_front();
+    }
+    return;
+  }
+
+  retired_.clear();
+  if (files_.empty()) {
+    ++cursor_;
+  }
+  if (load_front()) {
+    settle();
+    front_type_ = classify_front();
+  }
+}
+
+size_t TokenStream::index() const {
+  return index_;
+}
+
+const StringPiece* TokenStream::begin() const {
+  return cursor_;
+}
+
+const StringPiece* TokenStream::end() const {
+  return end_;
+}
+
+bool TokenStream::is_response_file(const StringPiece& token) const {
+  return expand_ && token.size() > 1 && token[0] == '@';
+}
+
+bool TokenStream::load_front() {
+  while (!files_.empty() &&
+         !files_.back()->next(&front_, &scratch_[index_ % 2])) {
+    retired_.emplace_back(std::move(files_.back()));
+    files_.pop_back();
+  }
+  if (files_.empty()) {
+    if (cursor_ == end_) {
+      return false;
+    }
+    front_ = *cursor_;
+  }
+  return true;
+}
+
+void TokenStream::settle() {
+  while (is_response_file(front_) && files_.size() < kMaxResponseFileDepth) {
+    std::unique_ptr<ResponseFile> file =
+        ResponseFile::open(front_.substr(1).to_string());
+    if (!file) {
+      return;
+    }
+    if (files_.empty()) {
+      // NOTE(josh): the `@path` token is consumed from the array
+      ++cursor_;
+    }
+    files_.emplace_back(std::move(file));
+    if (!load_front()) {
+      return;
+    }
+  }
+}
+
+}  // namespace argue
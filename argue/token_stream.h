@@ -0,0 +1,143 @@
+#pragma once
+// Copyright 2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "argue/parse.h"
+#include "argue/response_file.h"
+#include "argue/util.h"
+
+namespace argue {
+
+// =============================================================================
+//                              Token Stream
+// =============================================================================
+
+// A read cursor over a contiguous sequence of argument tokens.
+/* The stream does not own the tokens or the characters they reference. When
+ * parsing from `argv` the tokens point directly into the argument vector so
+ * no argument is copied until an action actually stores its value.
+ *
+ * Actions consume arguments by inspecting `front()` and calling
+ * `pop_front()`, leaving the stream positioned at the first argument which
+ * they did not consume.
+ *
+ * If response files are enabled, a token `@path` is replaced by the
+ * arguments read from the file at `path` (see `ResponseFile`), which may
+ * themselves reference response files. The arguments are read as they are
+ * consumed. A token which comes from a response file remains valid until the
+ * token after it has been popped, so an action may still refer to the flag
+ * which selected it. */
+class TokenStream {
+ public:
+  TokenStream();
+  TokenStream(const StringPiece* begin, const StringPiece* end);
+  ~TokenStream();
+
+  // Start replacing `@path` tokens with the contents of the file at `path`.
+  /* A token `@path` is left as-is if the file cannot be read, or if response
+   * files are already nested `kMaxResponseFileDepth` deep. */
+  void expand_response_files();
+
+  // Return true if there are no tokens remaining in the stream
+  bool empty() const;
+
+  // Return the number of tokens remaining in the underlying array. This does
+  // not count arguments read from response files.
+  size_t size() const;
+
+  // Return the next token in the stream. The stream must not be empty.
+  const StringPiece& front() const;
+
+  // Return the ArgType of the next token. The stream must not be empty.
+  /* Each token is classified once: either by `positional_run()`, or if that
+   * has not classified it, when it reaches the front of the stream. Actions
+   * which peek at the same token do not classify it again. */
+  ArgType front_type() const;
+
+  // Return the number of consecutive positional tokens at the front of the
+  // stream.
+  /* The first call classifies the whole underlying array in a single pass and
+   * records the type of every token and the length of every run of
+   * positional tokens, so each later call is a lookup. Tokens in response
+   * files are not known ahead of time: if the front token was read from a
+   * file the result is at most 1, and if the run reaches an `@path` token
+   * which will be expanded it ends there. A list destination which is filled
+   * from a response file is therefore not sized ahead, and grows as its values
+   * are appended. */
+  size_t positional_run();
+
+  // Advance the cursor past the next token
+  void pop_front();
+
+  // Return the index of the next token, relative to the first token of the
+  // stream. This is equal to the number of tokens which have been consumed,
+  // including arguments read from response files.
+  size_t index() const;
+
+  // Iterate over the tokens remaining in the underlying array, without
+  // consuming them. This does not include arguments read from response files.
+  const StringPiece* begin() const;
+  const StringPiece* end() const;
+
+  static const size_t kMaxResponseFileDepth = 32;
+
+ private:
+  TokenStream(const TokenStream&) = delete;
+  TokenStream& operator=(const TokenStream&) = delete;
+
+  // Return true if `token` should be replaced by the contents of a file
+  bool is_response_file(const StringPiece& token) const;
+
+  // Read the next token into `front_`: from the innermost response file
+  // which is not exhausted, otherwise from the array. Returns false if there
+  // are no more tokens.
+  bool load_front();
+
+  // While `front_` names a response file, open it and read its first token
+  // into `front_`.
+  void settle();
+
+  // Classify the underlying array and fill `classes_`
+  void classify();
+
+  // Classify `front_`, from `classes_` if it is a token of the array which
+  // has already been classified.
+  ArgType classify_front() const;
+
+  const StringPiece* begin_;   //< first token of the stream
+  const StringPiece* cursor_;  //< next token of the array to be consumed
+  const StringPiece* end_;     //< one past the last token of the stream
+  size_t index_;               //< number of tokens consumed
+  bool expand_;                //< true if response files are expanded
+  StringPiece front_;          //< the next token, see `front()`
+  ArgType front_type_;         //< classification of `front_`
+
+  // Classification of a token of the underlying array
+  struct TokenClass {
+    uint32_t run;  //< number of consecutive positional tokens from this one
+    ArgType type;  //< see `get_arg_type()`
+  };
+
+  // Classification of each token of the underlying array. Empty until
+  // `classify()`.
+  std::vector<TokenClass> classes_;
+
+  // Stack of response files being read, the innermost is last. If this is
+  // not empty then `front_` was read from the innermost file.
+  std::vector<std::unique_ptr<ResponseFile>> files_;
+
+  // Response files which ran out during the last `pop_front()`. They are
+  // kept until the next one because the previous token may reference them.
+  std::vector<std::unique_ptr<ResponseFile>> retired_;
+
+  // Storage for unquoted arguments. The token at index `i` is stored in
+  // `scratch_[i % 2]` so that the previous token remains valid.
+  std::string scratch_[2];
+};
+
+}  // namespace argue
@@ -1,6 +1,14 @@
 #pragma once
 // Copyright 2018-2020 Josh Bialkowski <josh.bialkowski@gmail.com>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <list>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <utility>
 #include <vector>
 
 namespace argue {
@@ -9,6 +17,76 @@ namespace argue {
 //                                 Utilities
 // =============================================================================
 
+// Non-owning reference to a contiguous sequence of characters.
+/* This is a minimal stand-in for c++17 `std::string_view`, so that argument
+ * tokens can be passed around without copying them into `std::string` while
+ * we still support building with `-std=c++11`. The referenced memory must
+ * outlive the piece. */
+class StringPiece {
+ public:
+  StringPiece() : data_(nullptr), size_(0) {}
+  StringPiece(const char* data, size_t size) : data_(data), size_(size) {}
+  StringPiece(const char* str)  // NOLINT(runtime/explicit)
+      : data_(str), size_(str ? std::strlen(str) : 0) {}
+  StringPiece(const std::string& str)  // NOLINT(runtime/explicit)
+      : data_(str.data()), size_(str.size()) {}
+
+  const char* data() const {
+    return data_;
+  }
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  const char* begin() const {
+    return data_;
+  }
+  const char* end() const {
+    return data_ + size_;
+  }
+  char operator[](size_t idx) const {
+    return data_[idx];
+  }
+
+  // Return a new piece referencing the characters starting at `pos`
+  StringPiece substr(size_t pos, size_t count = std::string::npos) const;
+
+  // Return true if the first characters of this piece match `prefix`
+  bool starts_with(const StringPiece& prefix) const;
+
+  // Lexicographic comparison, returns <0, 0, or >0 like `strcmp`
+  int compare(const StringPiece& other) const;
+
+  // Copy the referenced characters into a new string
+  std::string to_string() const {
+    return std::string(data_, size_);
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+bool operator==(const StringPiece& a, const StringPiece& b);
+bool operator!=(const StringPiece& a, const StringPiece& b);
+bool operator<(const StringPiece& a, const StringPiece& b);
+std::ostream& operator<<(std::ostream& out, const StringPiece& piece);
+
+// Return the 64-bit FNV-1a hash of a string
+uint64_t hash_string(const StringPiece& str);
+
+// Return the subrange of [first, last) whose keys start with `prefix`
+/* `get_key` maps an element to its `StringPiece` key and the range must be
+ * sorted by that key. The elements matching a prefix are contiguous in such a
+ * range so this takes two binary searches, rather than a scan of the whole
+ * range. */
+template <class Iterator, class KeyFn>
+std::pair<Iterator, Iterator> prefix_range(Iterator first, Iterator last,
+                                           const StringPiece& prefix,
+                                           KeyFn get_key);
+
 // Create a string formed by repeating `bit` for `n` times.
 std::string repeat(const std::string bit, int n);
 
@@ -28,6 +106,40 @@ std::vector<typename Container::key_type> keys(const Container& container);
 template <typename Container>
 typename Container::value_type container_sum(const Container& container);
 
+// Identifies a type, or no type if default constructed
+/* Wraps `std::type_info` rather than the address of some per-type static, so
+ * that the same type compares equal on both sides of a shared library
+ * boundary (e.g. an options struct declared in a program and passed to a
+ * parser built inside `libargue.so`, or vice versa). */
+class TypeId {
+ public:
+  TypeId() : info_(nullptr) {}
+  explicit TypeId(const std::type_info& info) : info_(&info) {}
+
+  // Return true if this identifies a type
+  explicit operator bool() const {
+    return info_ != nullptr;
+  }
+
+  bool operator==(const TypeId& other) const {
+    if (info_ == other.info_) {
+      return true;
+    }
+    return info_ && other.info_ && *info_ == *other.info_;
+  }
+
+  bool operator!=(const TypeId& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  const std::type_info* info_;
+};
+
+// Return the identifier of the type `T`
+template <typename T>
+TypeId type_id();
+
 // Template metaprogram evaluates to the value type of a container or the
 // input type of a non container. The default template is for scalar types
 // and just evaluates to the input type.
@@ -65,6 +177,77 @@ class ElementType<std::vector<T, Allocator>> {
 
 namespace argue {
 
+inline StringPiece StringPiece::substr(size_t pos, size_t count) const {
+  if (pos > size_) {
+    pos = size_;
+  }
+  if (count > size_ - pos) {
+    count = size_ - pos;
+  }
+  return StringPiece(data_ + pos, count);
+}
+
+inline bool StringPiece::starts_with(const StringPiece& prefix) const {
+  return size_ >= prefix.size_ &&
+         std::memcmp(data_, prefix.data_, prefix.size_) == 0;
+}
+
+inline int StringPiece::compare(const StringPiece& other) const {
+  size_t common = size_ < other.size_ ? size_ : other.size_;
+  int result = common ? std::memcmp(data_, other.data_, common) : 0;
+  if (result != 0) {
+    return result;
+  }
+  if (size_ == other.size_) {
+    return 0;
+  }
+  return size_ < other.size_ ? -1 : 1;
+}
+
+inline bool operator==(const StringPiece& a, const StringPiece& b) {
+  return a.size() == b.size() && a.compare(b) == 0;
+}
+
+inline bool operator!=(const StringPiece& a, const StringPiece& b) {
+  return !(a == b);
+}
+
+inline bool operator<(const StringPiece& a, const StringPiece& b) {
+  return a.compare(b) < 0;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const StringPiece& piece) {
+  return out.write(piece.data(), piece.size());
+}
+
+template <typename T>
+TypeId type_id() {
+  return TypeId(typeid(T));
+}
+
+inline uint64_t hash_string(const StringPiece& str) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+template <class Iterator, class KeyFn>
+std::pair<Iterator, Iterator> prefix_range(Iterator first, Iterator last,
+                                           const StringPiece& prefix,
+                                           KeyFn get_key) {
+  typedef typename std::iterator_traits<Iterator>::value_type Value;
+  first = std::partition_point(first, last, [&](const Value& elem) {
+    return get_key(elem) < prefix;
+  });
+  last = std::partition_point(first, last, [&](const Value& elem) {
+    return get_key(elem).starts_with(prefix);
+  });
+  return std::make_pair(first, last);
+}
+
 template <typename T>
 bool has_choice(const std::vector<T>& choices, const T& query) {
   for (const T& choice : choices) {